@@ -0,0 +1,563 @@
+// clock_gettime is POSIX and syscall a glibc extension, neither is
+// declared under a strict -std=c11
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+#ifndef _DEFAULT_SOURCE
+#define _DEFAULT_SOURCE
+#endif
+#include "dynarr.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+// Runs the DynArr operation kernels under hardware counters and compares
+// them against a JSON baseline:
+//
+//     make baseline                save this machine's baseline
+//     make perf-check              fail on a regression against it
+//
+//     ./bench                      print the results as JSON
+//     ./bench --save FILE          write the results as the baseline
+//     ./bench --check FILE [--tolerance 0.10]
+//
+// --check exits with 1 when a kernel got worse than the baseline by more
+// than the tolerance, 2 on errors. Counters are compared when both runs
+// have them, the time otherwise (no perf_event_open, perf_event_paranoid
+// too high, or no PMU exposed, as in most VMs). Baselines only mean
+// something on the machine that saved them
+
+#define BENCH_REPEATS 5
+#define BENCH_DEFAULT_TOLERANCE 0.10
+#define BENCH_FIND_LEN 1000000
+#define BENCH_FIND_LOOKUPS 200000
+#define BENCH_INSERT_LEN 50000
+#define BENCH_INSERT_COUNT 5000
+#define BENCH_SORT_LEN 500000
+#define BENCH_MAX_BASELINE 64
+#define BENCH_MAX_NAME 32
+
+typedef enum bench_metric{
+    NS_BENCH_METRIC,
+    CYCLES_BENCH_METRIC,
+    INSTRUCTIONS_BENCH_METRIC,
+    LLC_MISSES_BENCH_METRIC,
+    BRANCH_MISSES_BENCH_METRIC,
+    BENCH_METRIC_COUNT
+}BenchMetric;
+
+static const char *metric_names[BENCH_METRIC_COUNT] = {
+    "ns",
+    "cycles",
+    "instructions",
+    "llc_misses",
+    "branch_misses"
+};
+
+// -1 for metrics that could not be read
+typedef struct bench_result{
+    const char *name;
+    long long metrics[BENCH_METRIC_COUNT];
+}BenchResult;
+
+typedef struct bench_baseline{
+    char name[BENCH_MAX_NAME];
+    long long metrics[BENCH_METRIC_COUNT];
+}BenchBaseline;
+
+typedef struct bench_kernel{
+    const char *name;
+    DynArr *(*setup)(void);
+    void (*run)(DynArr *dynarr);
+}BenchKernel;
+
+static int counter_fds[BENCH_METRIC_COUNT] = {-1, -1, -1, -1, -1};
+// why the cycles counter failed to open: EACCES for perf_event_paranoid,
+// ENOENT when there is no PMU
+static int counter_errno = ENOSYS;
+static unsigned long long rng_state = 88172645463325252ULL;
+
+static unsigned long long next_random(void){
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+
+    return rng_state;
+}
+
+static int compare_int(const void *a, const void *b){
+    int a_value = *(const int *)a;
+    int b_value = *(const int *)b;
+
+    return (a_value > b_value) - (a_value < b_value);
+}
+
+static long long now_ns(void){
+    struct timespec time;
+
+    clock_gettime(CLOCK_MONOTONIC, &time);
+
+    return (long long)time.tv_sec * 1000000000LL + time.tv_nsec;
+}
+
+#ifdef __linux__
+static int open_counter(unsigned int type, unsigned long long config){
+    struct perf_event_attr attr;
+
+    memset(&attr, 0, sizeof(attr));
+
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+#endif
+
+// each counter on its own, machines missing one still report the others
+static void open_counters(void){
+#ifdef __linux__
+    counter_fds[CYCLES_BENCH_METRIC] = open_counter(
+        PERF_TYPE_HARDWARE,
+        PERF_COUNT_HW_CPU_CYCLES
+    );
+    counter_errno = errno;
+    counter_fds[INSTRUCTIONS_BENCH_METRIC] = open_counter(
+        PERF_TYPE_HARDWARE,
+        PERF_COUNT_HW_INSTRUCTIONS
+    );
+    counter_fds[LLC_MISSES_BENCH_METRIC] = open_counter(
+        PERF_TYPE_HARDWARE,
+        PERF_COUNT_HW_CACHE_MISSES
+    );
+    counter_fds[BRANCH_MISSES_BENCH_METRIC] = open_counter(
+        PERF_TYPE_HARDWARE,
+        PERF_COUNT_HW_BRANCH_MISSES
+    );
+#endif
+}
+
+static void close_counters(void){
+#ifdef __linux__
+    for (int i = 0; i < BENCH_METRIC_COUNT; i++){
+        if(counter_fds[i] != -1){
+            close(counter_fds[i]);
+        }
+    }
+#endif
+}
+
+static void start_counters(void){
+#ifdef __linux__
+    for (int i = 0; i < BENCH_METRIC_COUNT; i++){
+        if(counter_fds[i] != -1){
+            ioctl(counter_fds[i], PERF_EVENT_IOC_RESET, 0);
+            ioctl(counter_fds[i], PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+#endif
+}
+
+static void stop_counters(long long *metrics){
+    for (int i = 0; i < BENCH_METRIC_COUNT; i++){
+        if(i == NS_BENCH_METRIC){
+            continue;
+        }
+
+        metrics[i] = -1;
+
+#ifdef __linux__
+        long long value;
+
+        if(counter_fds[i] == -1){
+            continue;
+        }
+
+        ioctl(counter_fds[i], PERF_EVENT_IOC_DISABLE, 0);
+
+        if(read(counter_fds[i], &value, sizeof(value)) == sizeof(value)){
+            metrics[i] = value;
+        }
+#endif
+    }
+}
+
+// KERNELS
+static DynArr *setup_sorted(void){
+    DynArr *values = DYNARR_CREATE_TYPE_EXACT(NULL, int, BENCH_FIND_LEN);
+
+    for (int i = 0; i < BENCH_FIND_LEN; i++){
+        DYNARR_INSERT(values, int, i * 2);
+    }
+
+    return values;
+}
+
+static void run_find(DynArr *values){
+    volatile int found = 0;
+
+    for (int i = 0; i < BENCH_FIND_LOOKUPS; i++){
+        int value = (int)(next_random() % (BENCH_FIND_LEN * 2));
+
+        found += dynarr_find(values, &value, compare_int) != -1;
+    }
+}
+
+static DynArr *setup_insert(void){
+    DynArr *values = DYNARR_CREATE_TYPE_EXACT(NULL, int, BENCH_INSERT_LEN + BENCH_INSERT_COUNT);
+
+    for (int i = 0; i < BENCH_INSERT_LEN; i++){
+        DYNARR_INSERT(values, int, i);
+    }
+
+    return values;
+}
+
+static void run_insert_at(DynArr *values){
+    for (int i = 0; i < BENCH_INSERT_COUNT; i++){
+        size_t idx = (size_t)(next_random() % dynarr_len(values));
+
+        DYNARR_INSERT_AT(values, idx, int, i);
+    }
+}
+
+static DynArr *setup_random(void){
+    DynArr *values = DYNARR_CREATE_TYPE_EXACT(NULL, int, BENCH_SORT_LEN);
+
+    for (int i = 0; i < BENCH_SORT_LEN; i++){
+        DYNARR_INSERT(values, int, (int)(next_random() % BENCH_SORT_LEN));
+    }
+
+    return values;
+}
+
+static void run_sort(DynArr *values){
+    dynarr_sort(values, compare_int);
+}
+
+static const BenchKernel kernels[] = {
+    {"find", setup_sorted, run_find},
+    {"insert_at", setup_insert, run_insert_at},
+    {"sort", setup_random, run_sort},
+};
+
+#define KERNEL_COUNT (sizeof(kernels) / sizeof(kernels[0]))
+
+// best of BENCH_REPEATS runs, every metric on its own
+static void run_kernel(const BenchKernel *kernel, BenchResult *result){
+    result->name = kernel->name;
+
+    for (int i = 0; i < BENCH_METRIC_COUNT; i++){
+        result->metrics[i] = -1;
+    }
+
+    for (int repeat = 0; repeat < BENCH_REPEATS; repeat++){
+        long long metrics[BENCH_METRIC_COUNT];
+        DynArr *dynarr = kernel->setup();
+
+        if(!dynarr){
+            fprintf(stderr, "bench: out of memory\n");
+            exit(2);
+        }
+
+        long long start = now_ns();
+
+        start_counters();
+        kernel->run(dynarr);
+        stop_counters(metrics);
+
+        metrics[NS_BENCH_METRIC] = now_ns() - start;
+
+        dynarr_destroy(dynarr);
+
+        for (int i = 0; i < BENCH_METRIC_COUNT; i++){
+            if(metrics[i] != -1 && (result->metrics[i] == -1 || metrics[i] < result->metrics[i])){
+                result->metrics[i] = metrics[i];
+            }
+        }
+    }
+}
+
+// JSON
+static void write_results(FILE *file, const BenchResult *results, size_t count){
+    fprintf(file, "{\n    \"kernels\": [\n");
+
+    // one kernel per line, read_baseline relies on it
+    for (size_t i = 0; i < count; i++){
+        fprintf(file, "        {\"name\": \"%s\"", results[i].name);
+
+        for (int j = 0; j < BENCH_METRIC_COUNT; j++){
+            fprintf(file, ", \"%s\": %lld", metric_names[j], results[i].metrics[j]);
+        }
+
+        fprintf(file, "}%s\n", i + 1 < count ? "," : "");
+    }
+
+    fprintf(file, "    ]\n}\n");
+}
+
+// parses one kernel line exactly as write_results prints it
+static int parse_kernel_line(const char *line, BenchBaseline *out_baseline, int *out_last){
+    const char *prefix = "        {\"name\": \"";
+    size_t prefix_len = strlen(prefix);
+
+    if(strncmp(line, prefix, prefix_len) != 0){
+        return 0;
+    }
+
+    const char *name = line + prefix_len;
+    const char *name_end = strchr(name, '"');
+
+    if(!name_end || name_end == name || name_end - name >= BENCH_MAX_NAME){
+        return 0;
+    }
+
+    memcpy(out_baseline->name, name, name_end - name);
+    out_baseline->name[name_end - name] = '\0';
+
+    const char *cursor = name_end + 1;
+
+    for (int i = 0; i < BENCH_METRIC_COUNT; i++){
+        char pattern[64];
+        char *number_end;
+
+        snprintf(pattern, sizeof(pattern), ", \"%s\": ", metric_names[i]);
+
+        if(strncmp(cursor, pattern, strlen(pattern)) != 0){
+            return 0;
+        }
+
+        cursor += strlen(pattern);
+        errno = 0;
+        out_baseline->metrics[i] = strtoll(cursor, &number_end, 10);
+
+        if(number_end == cursor || errno || out_baseline->metrics[i] < -1){
+            return 0;
+        }
+
+        cursor = number_end;
+    }
+
+    if(strcmp(cursor, "},\n") == 0){
+        *out_last = 0;
+        return 1;
+    }
+
+    if(strcmp(cursor, "}\n") == 0){
+        *out_last = 1;
+        return 1;
+    }
+
+    return 0;
+}
+
+// Reads a baseline. Only the layout write_results produces is accepted,
+// one kernel per line with every metric in order, not JSON in general:
+// a file edited by hand or by another tool is rejected, returning -1
+static int read_baseline(FILE *file, BenchBaseline *out_baselines, size_t *out_count){
+    const char *header[] = {"{\n", "    \"kernels\": [\n"};
+    const char *footer[] = {"    ]\n", "}\n"};
+    char line[512];
+    size_t count = 0;
+    int last = 0;
+
+    for (size_t i = 0; i < 2; i++){
+        if(!fgets(line, sizeof(line), file) || strcmp(line, header[i]) != 0){
+            return -1;
+        }
+    }
+
+    while (fgets(line, sizeof(line), file) && strcmp(line, footer[0]) != 0){
+        if(last || count == BENCH_MAX_BASELINE){
+            return -1;
+        }
+
+        if(!parse_kernel_line(line, &out_baselines[count++], &last)){
+            return -1;
+        }
+    }
+
+    // the closing bracket was read by the loop, unless the file ended
+    if(strcmp(line, footer[0]) != 0 || (count > 0 && !last)){
+        return -1;
+    }
+
+    if(!fgets(line, sizeof(line), file) || strcmp(line, footer[1]) != 0 || fgets(line, sizeof(line), file)){
+        return -1;
+    }
+
+    *out_count = count;
+
+    return 0;
+}
+
+static const BenchBaseline *find_baseline(const BenchBaseline *baselines, size_t count, const char *name){
+    for (size_t i = 0; i < count; i++){
+        if(strcmp(baselines[i].name, name) == 0){
+            return &baselines[i];
+        }
+    }
+
+    return NULL;
+}
+
+static int check_results(
+    const BenchBaseline *baselines,
+    size_t baselines_count,
+    const BenchResult *results,
+    size_t count,
+    double tolerance
+){
+    int regressions = 0;
+
+    for (size_t i = 0; i < count; i++){
+        const BenchBaseline *baseline = find_baseline(baselines, baselines_count, results[i].name);
+
+        if(!baseline){
+            printf("%-10s no baseline\n", results[i].name);
+            continue;
+        }
+
+        int compared = 0;
+
+        for (int j = CYCLES_BENCH_METRIC; j < BENCH_METRIC_COUNT; j++){
+            long long before = baseline->metrics[j];
+            long long after = results[i].metrics[j];
+
+            if(before < 0 || after < 0){
+                continue;
+            }
+
+            int regressed = after > before * (1.0 + tolerance) &&
+                            after - before > 1000;
+
+            printf(
+                "%-10s %-14s %14lld -> %14lld%s\n",
+                results[i].name,
+                metric_names[j],
+                before,
+                after,
+                regressed ? "  REGRESSION" : ""
+            );
+
+            regressions += regressed;
+            compared = 1;
+        }
+
+        if(compared){
+            continue;
+        }
+
+        long long before = baseline->metrics[NS_BENCH_METRIC];
+        long long after = results[i].metrics[NS_BENCH_METRIC];
+        int regressed = after > before * (1.0 + tolerance);
+
+        printf(
+            "%-10s %-14s %14lld -> %14lld%s\n",
+            results[i].name,
+            metric_names[NS_BENCH_METRIC],
+            before,
+            after,
+            regressed ? "  REGRESSION" : ""
+        );
+
+        regressions += regressed;
+    }
+
+    return regressions;
+}
+
+static void usage(void){
+    fprintf(stderr, "usage: bench [--save FILE | --check FILE [--tolerance RATIO]]\n");
+}
+
+int main(int argc, char **argv){
+    const char *save_path = NULL;
+    const char *check_path = NULL;
+    double tolerance = BENCH_DEFAULT_TOLERANCE;
+
+    for (int i = 1; i < argc; i++){
+        if(strcmp(argv[i], "--save") == 0 && i + 1 < argc){
+            save_path = argv[++i];
+        }else if(strcmp(argv[i], "--check") == 0 && i + 1 < argc){
+            check_path = argv[++i];
+        }else if(strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc){
+            tolerance = atof(argv[++i]);
+        }else{
+            usage();
+            return 2;
+        }
+    }
+
+    BenchBaseline baselines[BENCH_MAX_BASELINE];
+    size_t baselines_count = 0;
+
+    // the baseline is checked before spending time on the kernels
+    if(check_path){
+        FILE *file = fopen(check_path, "r");
+
+        if(!file){
+            fprintf(stderr, "bench: cannot read %s\n", check_path);
+            return 2;
+        }
+
+        int read = read_baseline(file, baselines, &baselines_count);
+
+        fclose(file);
+
+        if(read){
+            fprintf(stderr, "bench: %s is not a baseline written by --save\n", check_path);
+            return 2;
+        }
+    }
+
+    BenchResult results[KERNEL_COUNT];
+
+    open_counters();
+
+    if(counter_fds[CYCLES_BENCH_METRIC] == -1){
+        fprintf(stderr, "bench: hardware counters unavailable (%s), timing only\n", strerror(counter_errno));
+    }
+
+    for (size_t i = 0; i < KERNEL_COUNT; i++){
+        run_kernel(&kernels[i], &results[i]);
+    }
+
+    close_counters();
+
+    if(check_path){
+        int regressions = check_results(baselines, baselines_count, results, KERNEL_COUNT, tolerance);
+
+        return regressions > 0;
+    }
+
+    if(save_path){
+        FILE *file = fopen(save_path, "w");
+
+        if(!file){
+            fprintf(stderr, "bench: cannot write %s\n", save_path);
+            return 2;
+        }
+
+        write_results(file, results, KERNEL_COUNT);
+
+        return fclose(file) != 0 ? 2 : 0;
+    }
+
+    write_results(stdout, results, KERNEL_COUNT);
+
+    return 0;
+}
@@ -1,10 +1,274 @@
+// pread, pwrite and fdatasync are POSIX, not C. _DEFAULT_SOURCE keeps
+// the glibc extensions (madvise) that _POSIX_C_SOURCE alone would hide
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#ifndef _DEFAULT_SOURCE
+#define _DEFAULT_SOURCE
+#endif
+
 #include "dynarr.h"
 
+#include <stdio.h>
+#include <stdatomic.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define DYNARR_POSIX
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+// items buffer shared between clones, or living in a file mapping
+typedef struct dynarr_share{
+    size_t refs;
+    void *mapping;
+    size_t mapping_size;
+}DynArrShare;
+
+#define DYNARR_FILE_MAGIC "DYNA"
+#define DYNARR_FILE_VERSION 1
+
+// on disk layout, in native byte order, followed by the raw items
+typedef struct dynarr_file_header{
+    char magic[4];
+    uint32_t version;
+    uint64_t item_size;
+    uint64_t len;
+    uint64_t checksum;
+}DynArrFileHeader;
+
+#ifndef DYNARR_HUGE_PAGE_THRESHOLD
+#define DYNARR_HUGE_PAGE_THRESHOLD (2 * 1024 * 1024)
+#endif
+
+#define DYNARR_CHECKSUM_SEED UINT64_C(14695981039346656037)
+
+#ifndef DYNARR_PERSIST_MAX_RANGES
+#define DYNARR_PERSIST_MAX_RANGES 1024
+#endif
+
+typedef struct dynarr_persist DynArrPersist;
+
 struct dynarr{
     size_t used;
     size_t capacity;
     size_t item_size;
     char *items;
+    // 'items' sits 'items_offset' bytes into the allocated block so it
+    // honors 'alignment'. Zero alignment takes what the allocator gives
+    size_t alignment;
+    size_t items_offset;
+    int huge_pages;
+    // set when 'items' is shared by dynarr_clone or mapped from a file
+    DynArrShare *share;
+    // set when backed by a file through dynarr_persist_open
+    DynArrPersist *persist;
+    // links in the registry of live DynArrs. Those from dynarr_init live
+    // in caller storage and are left out
+    int tracked;
+    DynArr *tracked_prev;
+    DynArr *tracked_next;
+    const DynArrAllocator *allocator;
+};
+
+// every live DynArr the library owns the storage of, plus the bytes the
+// items buffers of all DynArrs hold. Mapped files are not counted, only
+// what came from an allocator
+typedef struct dynarr_registry{
+    atomic_flag lock;
+    DynArr *head;
+    size_t reserved;
+    size_t limit;
+    DynArrMemoryPressure on_pressure;
+    void *pressure_ctx;
+}DynArrRegistry;
+
+static DynArrRegistry registry = {.lock = ATOMIC_FLAG_INIT};
+
+typedef struct dirty_range{
+    size_t from;
+    size_t to;
+}DirtyRange;
+
+// file backing of a DynArr opened by dynarr_persist_open
+struct dynarr_persist{
+    int fd;
+    size_t published_len;
+    // checksum state over the first 'hashed_size' bytes of items, which
+    // is a multiple of 8 and never touched since the last flush
+    uint64_t hash;
+    size_t hashed_size;
+    // items changed since the last flush, in item indexes
+    DynArr ranges;
+};
+
+struct dynarr_cols{
+    size_t len;
+    size_t col_count;
+    DynArr *columns;
+    const DynArrAllocator *allocator;
+};
+
+// bits past 'len' in the last word are always kept clear
+struct dynarr_bits{
+    size_t len;
+    DynArr words;
+};
+
+typedef enum bits_op{
+    AND_BITS_OP,
+    OR_BITS_OP,
+    XOR_BITS_OP
+}BitsOp;
+
+typedef struct batch_edit{
+    size_t idx;
+    // index in the batch items of what to insert, SIZE_MAX for removes
+    size_t item;
+}BatchEdit;
+
+struct dynarr_batch{
+    DynArr edits;
+    DynArr items;
+};
+
+// piece of the array being built by dynarr_batch_apply: either a run
+// [from, to) of the original items, or the batch item 'from'
+typedef struct batch_segment{
+    size_t from;
+    size_t to;
+    int inserted;
+}BatchSegment;
+
+#define NO_BATCH_NODE SIZE_MAX
+
+// node of the treap dynarr_batch_apply keeps the segments in, ordered
+// by position. 'weight' counts the items of the whole subtree, so an
+// index finds its segment in O(log segments)
+typedef struct batch_node{
+    BatchSegment segment;
+    size_t weight;
+    size_t left;
+    size_t right;
+}BatchNode;
+
+#define PACKED_BLOCK_LEN 128
+
+// values of a block are its first value followed by the deltas between
+// consecutive values, bit packed with the width of the largest delta
+typedef struct packed_block{
+    uint64_t first;
+    size_t word_offset;
+    size_t width;
+}PackedBlock;
+
+struct dynarr_packed{
+    size_t len;
+    size_t item_size;
+    DynArr blocks;
+    DynArr words;
+};
+
+// payload of an item of a DynArrVar, 'size' bytes at 'offset' in the arena
+typedef struct var_entry{
+    size_t offset;
+    size_t size;
+}VarEntry;
+
+struct dynarr_var{
+    DynArr entries;
+    DynArr bytes;
+};
+
+// density bounds of the PMA windows, interpolated between the leaf
+// segments and the whole array
+#define PMA_LEAF_UPPER 1.0
+#define PMA_ROOT_UPPER 0.75
+#define PMA_LEAF_LOWER 0.125
+#define PMA_ROOT_LOWER 0.3
+#define PMA_MIN_CAPACITY DYNARR_DEFAULT_GROW_SIZE
+
+struct dynarr_pma{
+    size_t len;
+    size_t segment_len;
+    DynArrComparator comparator;
+    // every slot is part of 'used', 'occupied' tells which hold an item
+    DynArr slots;
+    DynArr occupied;
+};
+
+#define CACHE_LINE_SIZE 64
+
+#ifndef DYNARR_BLOCK_BYTES
+#define DYNARR_BLOCK_BYTES 16384
+#endif
+
+#ifdef __GNUC__
+#define PREFETCH(_addr) __builtin_prefetch((_addr), 0, 3)
+#else
+#define PREFETCH(_addr) ((void)(_addr))
+#endif
+
+#ifndef DYNARR_PARALLEL_THRESHOLD
+#define DYNARR_PARALLEL_THRESHOLD 16384
+#endif
+
+#ifndef DYNARR_PARALLEL_CHUNK_BYTES
+#define DYNARR_PARALLEL_CHUNK_BYTES 16384
+#endif
+
+// chunks [next, end) still owned by a participant. Others steal from
+// the same cursor once they run out of their own chunks. Padded to a
+// cache line, so the cursors of two ranges never share one
+typedef struct chunk_range{
+    atomic_size_t next;
+    size_t end;
+    char pad[CACHE_LINE_SIZE - sizeof(atomic_size_t) - sizeof(size_t)];
+}ChunkRange;
+
+typedef struct parallel_job ParallelJob;
+typedef void (*ChunkRunner)(ParallelJob *job, size_t chunk, size_t from, size_t to);
+
+struct parallel_job{
+    size_t len;
+    // the first chunk is 'first_chunk_items' long, so the boundaries of
+    // the rest fall on cache lines of the written buffer
+    size_t first_chunk_items;
+    size_t chunk_items;
+    size_t chunk_count;
+    size_t participants;
+    // hands every worker joining the job its participant index
+    atomic_size_t joined;
+    ChunkRange *ranges;
+    ChunkRunner runner;
+    DynArr *dynarr;
+    DynArr *out;
+    DynArrForEach for_each;
+    DynArrMapper mapper;
+    DynArrCombiner combiner;
+    const void *identity;
+    // one accumulator per chunk, for reduce and scan
+    char *partials;
+    void *ctx;
+};
+
+struct dynarr_pool{
+    size_t thread_count;
+#ifdef DYNARR_POSIX
+    size_t threads_capacity;
+    pthread_t *threads;
+    pthread_mutex_t mutex;
+    pthread_cond_t work_cond;
+    pthread_cond_t done_cond;
+    size_t generation;
+    size_t pending;
+    int stop;
+    ParallelJob *job;
+#endif
     const DynArrAllocator *allocator;
 };
 
@@ -27,12 +291,137 @@ static void lzdealloc(void *ptr, size_t size, const DynArrAllocator *allocator);
 #define MEMORY_DEALLOC(_ptr, _type, _count, _allocator) \
     (lzdealloc((_ptr), sizeof(_type) * (_count), (_allocator)))
 
+static inline size_t raw_items_size(const DynArr *dynarr, size_t count);
+static inline size_t align_offset(const char *ptr, size_t alignment);
+static void advise_huge_pages(const DynArr *dynarr);
+static void registry_lock(void);
+static void registry_unlock(void);
+static void track(DynArr *dynarr);
+static DynArr *init_tracked(void *raw_dynarr, size_t item_size, const DynArrAllocator *allocator);
+static void untrack(DynArr *dynarr);
+static int charge_memory(size_t old_size, size_t new_size);
+static inline size_t held_items_size(const DynArr *dynarr);
+static int charge_growth(const DynArr *dynarr, size_t new_size);
+static int resize_items(DynArr *dynarr, size_t new_count);
 static int grow(DynArr *dynarr);
 static int grow_by(DynArr *dynarr, size_t new_count);
 static int shrink(DynArr *dynarr);
+static int fit_items(DynArr *dynarr);
+static int unshare_items(DynArr *dynarr);
+static void release_items(DynArr *dynarr);
+static int mark_dirty(DynArr *dynarr, size_t from, size_t to);
+static int prepare_write(DynArr *dynarr, size_t from, size_t to);
+static void persist_close(DynArr *dynarr);
 static inline void *get_slot(const DynArr *dynarr, size_t idx);
+static uint64_t checksum_words(uint64_t hash, const char *bytes, size_t word_count);
+static uint64_t checksum_bytes(uint64_t hash, const char *bytes, size_t size);
+static uint64_t checksum(const char *bytes, size_t size);
+static int check_header(const DynArrFileHeader *header, uint64_t available_size);
 #define CALC_ITMS_MOV_COUNT(_len, _from) ((_len) - (_from))
 static inline void move_items(DynArr *dynarr, size_t from, size_t to);
+static inline void swap_items(DynArr *dynarr, size_t a, size_t b);
+static int compare_idxs_desc(const void *a, const void *b);
+static void heap_sift_down(
+    DynArr *dynarr,
+    size_t base,
+    size_t len,
+    size_t idx,
+    DynArrComparator comparator
+);
+static size_t partition(
+    DynArr *dynarr,
+    size_t lo,
+    size_t hi,
+    DynArrComparator comparator
+);
+static void heap_select(
+    DynArr *dynarr,
+    size_t lo,
+    size_t hi,
+    size_t nth,
+    DynArrComparator comparator
+);
+static void merge_sort_indexes(
+    const DynArr *dynarr,
+    size_t *indexes,
+    size_t *temp,
+    size_t len,
+    DynArrComparator comparator
+);
+
+#define BITS_WORD_BITS 64
+#define BITS_WORD_IDX(_idx) ((_idx) / BITS_WORD_BITS)
+#define BITS_BIT_IDX(_idx) ((_idx) % BITS_WORD_BITS)
+#define BITS_WORD_COUNT(_len) (((_len) + BITS_WORD_BITS - 1) / BITS_WORD_BITS)
+static inline uint64_t *bits_words(const DynArrBits *bits);
+static inline void bits_clear_tail(DynArrBits *bits);
+static int bits_bulk_op(DynArrBits *to, const DynArrBits *from, BitsOp op);
+static size_t chunk_items_for(size_t item_size);
+static void split_chunks(ParallelJob *job, const DynArr *written, size_t len);
+static void run_chunks(ParallelJob *job, size_t self);
+static void pool_run(DynArrPool *pool, ParallelJob *job);
+#ifdef DYNARR_POSIX
+static void *pool_worker(void *raw_pool);
+#endif
+static void for_each_chunk(ParallelJob *job, size_t chunk, size_t from, size_t to);
+static void map_chunk(ParallelJob *job, size_t chunk, size_t from, size_t to);
+static void reduce_chunk(ParallelJob *job, size_t chunk, size_t from, size_t to);
+static void scan_chunk(ParallelJob *job, size_t chunk, size_t from, size_t to);
+static inline uint64_t batch_node_priority(size_t node);
+static inline size_t batch_node_weight(const BatchNode *nodes, size_t node);
+static inline void batch_node_update(BatchNode *nodes, size_t node);
+static size_t batch_merge(BatchNode *nodes, size_t left, size_t right);
+static void batch_split(
+    DynArr *nodes,
+    size_t node,
+    size_t pos,
+    size_t *out_left,
+    size_t *out_right
+);
+static int replay_edit(DynArr *nodes, size_t *root, size_t *len, const BatchEdit *edit);
+static void flatten_segments(const BatchNode *nodes, size_t node, DynArr *segments);
+static void move_segments(
+    DynArr *dynarr,
+    const DynArr *segments,
+    size_t new_len,
+    int leftwards
+);
+static inline const void *var_payload(const DynArrVar *var, const VarEntry *entry);
+static void merge_sort_entries(
+    const DynArrVar *var,
+    VarEntry *entries,
+    VarEntry *temp,
+    size_t len,
+    DynArrVarComparator comparator
+);
+static int compact_arena(DynArrVar *var);
+static size_t pma_segment_len(size_t capacity);
+static inline int pma_occupied(const DynArrPma *pma, size_t slot);
+static size_t pma_next_occupied(const DynArrPma *pma, size_t from, size_t to);
+static size_t pma_search(
+    const DynArrPma *pma,
+    const void *item,
+    int after_equals,
+    size_t *out_pred
+);
+static double pma_threshold(const DynArrPma *pma, size_t window_len, double leaf, double root);
+static size_t pma_count(const DynArrPma *pma, size_t start, size_t window_len);
+static size_t pma_compact(DynArrPma *pma, size_t start, size_t window_len);
+static void pma_spread(DynArrPma *pma, size_t start, size_t window_len, size_t count);
+static int pma_resize(DynArrPma *pma, size_t capacity);
+static inline uint64_t read_uint(const DynArr *dynarr, size_t idx);
+static inline size_t bit_width(uint64_t value);
+static void pack_bits(uint64_t *words, size_t count, size_t width, const uint64_t *values);
+static size_t decode_block(const DynArrPacked *packed, size_t block_idx, uint64_t *out_values);
+static size_t packed_search(const DynArrPacked *packed, uint64_t value, uint64_t *out_found);
+static inline size_t popcount_word(uint64_t word);
+static inline size_t ctz_word(uint64_t word);
+static int bits_find_first(
+    const DynArrBits *bits,
+    size_t from,
+    uint64_t flip,
+    size_t *out_idx
+);
 
 // PRIVATE IMPLEMENTATION
 void *lzalloc(size_t size, const DynArrAllocator *allocator){
@@ -58,455 +447,4303 @@ void lzdealloc(void *ptr, size_t size, const DynArrAllocator *allocator){
     }
 }
 
-static int grow(DynArr *dynarr){
-    size_t item_size = dynarr->item_size;
-    size_t old_count = dynarr->capacity;
-    size_t new_count = old_count == 0 ? DYNARR_DEFAULT_GROW_SIZE : old_count * 2;
-    size_t old_size = old_count * item_size;
-    size_t new_size = new_count * item_size;
+// bytes allocated for 'count' items, including what is needed to align
+static inline size_t raw_items_size(const DynArr *dynarr, size_t count){
+    size_t padding = dynarr->alignment > 1 ? dynarr->alignment - 1 : 0;
 
-    void *new_items = MEMORY_REALLOC(
-        dynarr->items,
-        char,
-        old_size,
-        new_size,
-        dynarr->allocator
-    );
+    return count * dynarr->item_size + padding;
+}
 
-    if (!new_items){
-        return 1;
+static inline size_t align_offset(const char *ptr, size_t alignment){
+    if(alignment <= 1){
+        return 0;
     }
 
-    dynarr->capacity = new_count;
-    dynarr->items = new_items;
-
-    return 0;
+    return (alignment - (uintptr_t)ptr % alignment) % alignment;
 }
 
-static int grow_by(DynArr *dynarr, size_t new_count){
-    size_t item_size = dynarr->item_size;
-    size_t old_count = dynarr->capacity;
-    size_t old_size = old_count * item_size;
-    size_t new_size = new_count * item_size;
+static void advise_huge_pages(const DynArr *dynarr){
+#if defined(DYNARR_POSIX) && defined(MADV_HUGEPAGE)
+    size_t size = dynarr->capacity * dynarr->item_size;
 
-    void *new_items = MEMORY_REALLOC(
-        dynarr->items,
-        char,
-        old_size,
-        new_size,
-        dynarr->allocator
-    );
+    if(!dynarr->huge_pages || !dynarr->items || size < DYNARR_HUGE_PAGE_THRESHOLD){
+        return;
+    }
 
-    if (!new_items){
-        return 1;
+    uintptr_t page_size = (uintptr_t)sysconf(_SC_PAGESIZE);
+    uintptr_t start = ((uintptr_t)dynarr->items + page_size - 1) / page_size * page_size;
+    uintptr_t end = ((uintptr_t)dynarr->items + size) / page_size * page_size;
+
+    // only a hint, nothing to do if the kernel refuses it
+    if(end > start){
+        madvise((void *)start, end - start, MADV_HUGEPAGE);
     }
+#else
+    (void)dynarr;
+#endif
+}
 
-    dynarr->capacity = new_count;
-    dynarr->items = new_items;
+static void registry_lock(void){
+    while (atomic_flag_test_and_set_explicit(&registry.lock, memory_order_acquire)){
+    }
+}
 
-    return 0;
+static void registry_unlock(void){
+    atomic_flag_clear_explicit(&registry.lock, memory_order_release);
 }
 
-static int shrink(DynArr *dynarr){
-    size_t item_size = dynarr->item_size;
-    size_t old_count = dynarr->capacity;
-    size_t new_count = old_count / 2;
-    size_t old_size = old_count * item_size;
-    size_t new_size = new_count * item_size;
+static void track(DynArr *dynarr){
+    registry_lock();
 
-    void *new_items = MEMORY_REALLOC(
-        dynarr->items,
-        char,
-        old_size,
-        new_size,
-        dynarr->allocator
-    );
+    dynarr->tracked = 1;
+    dynarr->tracked_prev = NULL;
+    dynarr->tracked_next = registry.head;
 
-    if (!new_items){
-        return 1;
+    if(registry.head){
+        registry.head->tracked_prev = dynarr;
     }
 
-    dynarr->capacity = new_count;
-    dynarr->items = new_items;
+    registry.head = dynarr;
 
-    return 0;
+    registry_unlock();
 }
 
-static inline void *get_slot(const DynArr *dynarr, size_t idx){
-    return ((char *)(dynarr->items)) + (idx * dynarr->item_size);
-}
+static void untrack(DynArr *dynarr){
+    if(!dynarr->tracked){
+        return;
+    }
 
-static inline void move_items(DynArr *dynarr, size_t from, size_t to){
-    size_t itms_mov_count = CALC_ITMS_MOV_COUNT(dynarr_len(dynarr), from);
+    registry_lock();
 
-    if(from == to || itms_mov_count == 0){
-        return;
+    if(dynarr->tracked_prev){
+        dynarr->tracked_prev->tracked_next = dynarr->tracked_next;
+    }else{
+        registry.head = dynarr->tracked_next;
     }
 
-    memmove(
-        get_slot(dynarr, to),
-        get_slot(dynarr, from),
-        itms_mov_count * dynarr->item_size
-    );
+    if(dynarr->tracked_next){
+        dynarr->tracked_next->tracked_prev = dynarr->tracked_prev;
+    }
+
+    dynarr->tracked = 0;
+
+    registry_unlock();
 }
 
-// public implementation
-DynArr *dynarr_init(void *raw_dynarr, size_t item_size, const DynArrAllocator *allocator){
-    DynArr *dynarr = raw_dynarr;
+// dynarr_init for DynArrs embedded in the library's own structs, which
+// are always deinitialized and so can join the registry
+static DynArr *init_tracked(void *raw_dynarr, size_t item_size, const DynArrAllocator *allocator){
+    DynArr *dynarr = dynarr_init(raw_dynarr, item_size, allocator);
 
-    dynarr->used = 0;
-    dynarr->capacity = 0;
-    dynarr->item_size = item_size;
-    dynarr->items = NULL;
-    dynarr->allocator = allocator;
+    track(dynarr);
 
     return dynarr;
 }
 
-DynArr *dynarr_create(const DynArrAllocator *allocator, size_t item_size){
-    DynArr *dynarr = MEMORY_ALLOC(DynArr, 1, allocator);
+// moves the reserved bytes from 'old_size' to 'new_size'. Growth past
+// the limit is refused, leaving the count as it was
+static int charge_memory(size_t old_size, size_t new_size){
+    registry_lock();
 
-    if(!dynarr){
-        return NULL;
+    size_t reserved = registry.reserved - old_size + new_size;
+    int refused = new_size > old_size && registry.limit > 0 && reserved > registry.limit;
+
+    if(!refused){
+        registry.reserved = reserved;
     }
 
-    dynarr->used = 0;
-    dynarr->capacity = 0;
-    dynarr->item_size = item_size;
-    dynarr->items = NULL;
-    dynarr->allocator = allocator;
+    registry_unlock();
 
-    return dynarr;
+    return refused;
 }
 
-DynArr *dynarr_create_by(
-    const DynArrAllocator *allocator,
-    size_t item_size,
-    size_t item_count
-){
-    size_t by = item_count / DYNARR_DEFAULT_GROW_SIZE + 1;
-    size_t new_capacity = DYNARR_DEFAULT_GROW_SIZE * by;
-    void *items = MEMORY_ALLOC(char, item_size * new_capacity, allocator);
-    DynArr *dynarr = MEMORY_ALLOC(DynArr, 1, allocator);
+static inline size_t held_items_size(const DynArr *dynarr){
+    return dynarr && dynarr->items ? raw_items_size(dynarr, dynarr->capacity) : 0;
+}
 
-    if(!items || !dynarr){
-        MEMORY_DEALLOC(items, char, item_size * item_count, allocator);
-        MEMORY_DEALLOC(dynarr, DynArr, 1, allocator);
+// charges replacing the items buffer of 'dynarr' by one of 'new_size'
+// bytes, or a fresh buffer if 'dynarr' is NULL. Past the limit the
+// pressure callback runs once before giving up
+static int charge_growth(const DynArr *dynarr, size_t new_size){
+    if(!charge_memory(held_items_size(dynarr), new_size)){
+        return 0;
+    }
 
-        return NULL;
+    registry_lock();
+
+    size_t reserved = registry.reserved - held_items_size(dynarr) + new_size;
+    size_t excess = reserved > registry.limit ? reserved - registry.limit : 0;
+    DynArrMemoryPressure on_pressure = registry.on_pressure;
+    void *ctx = registry.pressure_ctx;
+
+    registry_unlock();
+
+    if(!on_pressure){
+        return 1;
     }
 
-    dynarr->used = 0;
-    dynarr->capacity = new_capacity;
-    dynarr->item_size = item_size;
-    dynarr->items = items;
-    dynarr->allocator = allocator;
+    // outside the lock, the callback is expected to trim
+    on_pressure(excess, ctx);
 
-    return dynarr;
+    // sizes read again, the callback may have trimmed 'dynarr' itself
+    return charge_memory(held_items_size(dynarr), new_size);
 }
 
-void dynarr_deinit(DynArr *dynarr){
-    if (!dynarr){
-        return;
+static int resize_items(DynArr *dynarr, size_t new_count){
+    size_t new_size = raw_items_size(dynarr, new_count);
+
+    if(charge_growth(dynarr, new_size)){
+        return 1;
     }
 
-    MEMORY_DEALLOC(
-        dynarr->items,
+    // read after charging, the pressure callback may have trimmed 'dynarr'
+    size_t old_offset = dynarr->items_offset;
+    char *old_raw = dynarr->items ? dynarr->items - old_offset : NULL;
+    size_t old_size = old_raw ? raw_items_size(dynarr, dynarr->capacity) : 0;
+
+    char *new_raw = MEMORY_REALLOC(
+        old_raw,
         char,
-        dynarr->item_size * dynarr->capacity,
+        old_size,
+        new_size,
         dynarr->allocator
     );
-}
 
-void dynarr_destroy(DynArr *dynarr){
-    if (!dynarr){
-        return;
+    if (!new_raw){
+        charge_memory(new_size, old_size);
+        return 1;
     }
 
-    const DynArrAllocator *allocator = dynarr->allocator;
+    size_t new_offset = align_offset(new_raw, dynarr->alignment);
 
-    MEMORY_DEALLOC(
-        dynarr->items,
-        char,
-        dynarr->item_size * dynarr->capacity,
-        allocator
-    );
-    MEMORY_DEALLOC(
-        dynarr,
-        DynArr,
-        1,
-        allocator
-    );
-}
+    // realloc keeps the bytes but not the alignment of the items
+    if(old_raw && new_offset != old_offset){
+        size_t kept = dynarr->used < new_count ? dynarr->used : new_count;
 
-inline size_t dynarr_len(const DynArr *dynarr){
-    return dynarr->used;
-}
+        memmove(new_raw + new_offset, new_raw + old_offset, kept * dynarr->item_size);
+    }
 
-inline size_t dynarr_capacity(const DynArr *dynarr){
-    return dynarr->capacity;
-}
+    dynarr->capacity = new_count;
+    dynarr->items = new_raw + new_offset;
+    dynarr->items_offset = new_offset;
 
-inline size_t dynarr_item_size(const DynArr *dynarr){
-    return dynarr->item_size;
+    advise_huge_pages(dynarr);
+
+    return 0;
 }
 
-inline size_t dynarr_available(const DynArr *dynarr){
-    return dynarr->capacity - dynarr->used;
+static int grow(DynArr *dynarr){
+    size_t old_count = dynarr->capacity;
+    size_t new_count = old_count == 0 ? DYNARR_DEFAULT_GROW_SIZE : old_count * 2;
+
+    return resize_items(dynarr, new_count);
 }
 
-inline int dynarr_make_room(DynArr *dynarr, size_t count){
-    size_t by = count / DYNARR_DEFAULT_GROW_SIZE + 1;
-    size_t new_capacity = DYNARR_DEFAULT_GROW_SIZE * by + dynarr->capacity;
+static int grow_by(DynArr *dynarr, size_t new_count){
+    return resize_items(dynarr, new_count);
+}
 
-    return grow_by(dynarr, new_capacity);
+static int shrink(DynArr *dynarr){
+    return resize_items(dynarr, dynarr->capacity / 2);
 }
 
-inline int dynarr_reduce(DynArr *dynarr){
-    if(dynarr_len(dynarr) < dynarr->capacity / 2){
-        return !shrink(dynarr);
+// capacity down to the length, giving back the whole buffer when empty.
+// 'dynarr' must not be shared
+static int fit_items(DynArr *dynarr){
+    if(dynarr->used == dynarr->capacity){
+        return 0;
+    }
+
+    if(dynarr->used > 0){
+        return resize_items(dynarr, dynarr->used);
     }
 
+    release_items(dynarr);
+
+    dynarr->capacity = 0;
+    dynarr->items = NULL;
+    dynarr->items_offset = 0;
+
     return 0;
 }
 
-void dynarr_reverse(DynArr *dynarr){
-    size_t item_size = dynarr->item_size;
-    size_t len = dynarr_len(dynarr);
-    size_t until = dynarr_len(dynarr) / 2;
+// gives 'dynarr' its own copy of a buffer shared with clones. Must be
+// called before any write to the items
+static int unshare_items(DynArr *dynarr){
+    DynArrShare *share = dynarr->share;
 
-    for (size_t left_index = 0; left_index < until; left_index++){
-        size_t right_index = len - 1 - left_index;
-        char *left = get_slot(dynarr, left_index);
-        char *right = get_slot(dynarr, right_index);
-        char temp_item[item_size];
+    if(!share){
+        return 0;
+    }
 
-        memcpy(temp_item, left, item_size);
-        dynarr_set_at(dynarr, left_index, right);
-        dynarr_set_at(dynarr, right_index, temp_item);
+    if(share->refs == 1 && !share->mapping){
+        MEMORY_DEALLOC(share, DynArrShare, 1, dynarr->allocator);
+        dynarr->share = NULL;
+
+        return 0;
     }
-}
 
-inline void dynarr_sort(DynArr *dynarr, DynArrComparator comparator){
-    qsort(dynarr->items, dynarr->used, dynarr->item_size, comparator);
-}
+    size_t capacity = dynarr->capacity;
+    char *items = NULL;
+    size_t items_offset = 0;
 
-int dynarr_find(const DynArr *dynarr, const void *item, DynArrComparator comparator){
-    size_t len = dynarr_len(dynarr);
-    int low = 0;
-    int high = len == 0 ? 0 : len - 1;
+    if(capacity > 0){
+        size_t raw_size = raw_items_size(dynarr, capacity);
 
-    while (low <= high){
-        int middle_index = low + (high - low) / 2;
-        void *middle = get_slot(dynarr, (size_t)middle_index);
-        int comparison = comparator(middle, item);
+        if(charge_growth(NULL, raw_size)){
+            return 1;
+        }
 
-        if(comparison < 0){
-            low = middle_index + 1;
-        }else if(comparison > 0){
-            high = middle_index - 1;
-        }else{
-            return middle_index;
+        char *raw = MEMORY_ALLOC(char, raw_size, dynarr->allocator);
+
+        if(!raw){
+            charge_memory(raw_size, 0);
+            return 1;
         }
-    }
 
-    return -1;
-}
+        items_offset = align_offset(raw, dynarr->alignment);
+        items = raw + items_offset;
+
+        memcpy(items, dynarr->items, dynarr->item_size * dynarr->used);
+    }
+
+    release_items(dynarr);
+
+    dynarr->items = items;
+    dynarr->items_offset = items_offset;
+    dynarr->share = NULL;
+
+    advise_huge_pages(dynarr);
+
+    return 0;
+}
+
+// records that items in [from, to) are about to change, so the next
+// dynarr_persist_flush writes them
+static int mark_dirty(DynArr *dynarr, size_t from, size_t to){
+    DynArrPersist *persist = dynarr->persist;
+
+    if(!persist || from >= to){
+        return 0;
+    }
+
+    DynArr *ranges = &persist->ranges;
+    size_t ranges_len = dynarr_len(ranges);
+
+    if(ranges_len > 0){
+        DirtyRange *last = get_slot(ranges, ranges_len - 1);
+
+        // appends and repeated writes to the same area collapse here
+        if(from <= last->to && to >= last->from){
+            last->from = from < last->from ? from : last->from;
+            last->to = to > last->to ? to : last->to;
+
+            return 0;
+        }
+
+        // too many scattered writes, track them as a single range
+        if(ranges_len >= DYNARR_PERSIST_MAX_RANGES){
+            DirtyRange *first = get_slot(ranges, 0);
+
+            for (size_t i = 1; i < ranges_len; i++){
+                DirtyRange *range = get_slot(ranges, i);
+
+                first->from = range->from < first->from ? range->from : first->from;
+                first->to = range->to > first->to ? range->to : first->to;
+            }
+
+            first->from = from < first->from ? from : first->from;
+            first->to = to > first->to ? to : first->to;
+            ranges->used = 1;
+
+            return 0;
+        }
+    }
+
+    return dynarr_insert(ranges, &(DirtyRange){.from = from, .to = to});
+}
+
+static int prepare_write(DynArr *dynarr, size_t from, size_t to){
+    return unshare_items(dynarr) || mark_dirty(dynarr, from, to);
+}
+
+static void persist_close(DynArr *dynarr){
+    DynArrPersist *persist = dynarr->persist;
+
+    if(!persist){
+        return;
+    }
+
+#ifdef DYNARR_POSIX
+    close(persist->fd);
+#endif
+    dynarr_deinit(&persist->ranges);
+    MEMORY_DEALLOC(persist, DynArrPersist, 1, dynarr->allocator);
+
+    dynarr->persist = NULL;
+}
+
+static void release_items(DynArr *dynarr){
+    DynArrShare *share = dynarr->share;
+    size_t raw_size = dynarr->items ? raw_items_size(dynarr, dynarr->capacity) : 0;
+
+    if(!share){
+        charge_memory(raw_size, 0);
+        MEMORY_DEALLOC(
+            dynarr->items ? dynarr->items - dynarr->items_offset : NULL,
+            char,
+            raw_items_size(dynarr, dynarr->capacity),
+            dynarr->allocator
+        );
+
+        return;
+    }
+
+    if(--share->refs > 0){
+        return;
+    }
+
+    if(share->mapping){
+#ifdef DYNARR_POSIX
+        munmap(share->mapping, share->mapping_size);
+#endif
+    }else{
+        charge_memory(raw_size, 0);
+        MEMORY_DEALLOC(
+            dynarr->items ? dynarr->items - dynarr->items_offset : NULL,
+            char,
+            raw_items_size(dynarr, dynarr->capacity),
+            dynarr->allocator
+        );
+    }
+
+    MEMORY_DEALLOC(share, DynArrShare, 1, dynarr->allocator);
+}
+
+// FNV-1a taking 8 bytes per step, split so it can be resumed over a
+// growing buffer: all whole words first, then the trailing bytes
+static uint64_t checksum_words(uint64_t hash, const char *bytes, size_t word_count){
+    for (size_t i = 0; i < word_count; i++){
+        uint64_t word;
+
+        memcpy(&word, bytes + i * sizeof(uint64_t), sizeof(uint64_t));
+        hash = (hash ^ word) * UINT64_C(1099511628211);
+    }
+
+    return hash;
+}
+
+static uint64_t checksum_bytes(uint64_t hash, const char *bytes, size_t size){
+    for (size_t i = 0; i < size; i++){
+        hash = (hash ^ (uint8_t)bytes[i]) * UINT64_C(1099511628211);
+    }
+
+    return hash;
+}
+
+static uint64_t checksum(const char *bytes, size_t size){
+    size_t word_count = size / sizeof(uint64_t);
+    size_t words_size = word_count * sizeof(uint64_t);
+    uint64_t hash = checksum_words(DYNARR_CHECKSUM_SEED, bytes, word_count);
+
+    return checksum_bytes(hash, bytes + words_size, size - words_size);
+}
+
+// 'available_size' is how many bytes follow the header
+static int check_header(const DynArrFileHeader *header, uint64_t available_size){
+    if(memcmp(header->magic, DYNARR_FILE_MAGIC, sizeof(header->magic)) != 0 ||
+       header->version != DYNARR_FILE_VERSION ||
+       header->item_size == 0){
+        return FORMAT_ERR_DYNARR_CODE;
+    }
+
+    if(header->len > available_size / header->item_size ||
+       header->len > SIZE_MAX / header->item_size){
+        return FORMAT_ERR_DYNARR_CODE;
+    }
+
+    return OK_DYNARR_CODE;
+}
+
+static inline void *get_slot(const DynArr *dynarr, size_t idx){
+    return ((char *)(dynarr->items)) + (idx * dynarr->item_size);
+}
+
+static inline void move_items(DynArr *dynarr, size_t from, size_t to){
+    size_t itms_mov_count = CALC_ITMS_MOV_COUNT(dynarr_len(dynarr), from);
+
+    if(from == to || itms_mov_count == 0){
+        return;
+    }
+
+    memmove(
+        get_slot(dynarr, to),
+        get_slot(dynarr, from),
+        itms_mov_count * dynarr->item_size
+    );
+}
+
+static inline void swap_items(DynArr *dynarr, size_t a, size_t b){
+    size_t item_size = dynarr->item_size;
+    char *a_slot = get_slot(dynarr, a);
+    char *b_slot = get_slot(dynarr, b);
+    char temp_item[item_size];
+
+    memcpy(temp_item, a_slot, item_size);
+    memcpy(a_slot, b_slot, item_size);
+    memcpy(b_slot, temp_item, item_size);
+}
+
+static int compare_idxs_desc(const void *a, const void *b){
+    size_t a_idx = *(const size_t *)a;
+    size_t b_idx = *(const size_t *)b;
+
+    return (a_idx < b_idx) - (a_idx > b_idx);
+}
+
+// max-heap (according to comparator) living at [base, base + len)
+static void heap_sift_down(
+    DynArr *dynarr,
+    size_t base,
+    size_t len,
+    size_t idx,
+    DynArrComparator comparator
+){
+    while (1){
+        size_t left = idx * 2 + 1;
+        size_t right = left + 1;
+        size_t largest = idx;
+
+        if(left < len && comparator(get_slot(dynarr, base + left), get_slot(dynarr, base + largest)) > 0){
+            largest = left;
+        }
+
+        if(right < len && comparator(get_slot(dynarr, base + right), get_slot(dynarr, base + largest)) > 0){
+            largest = right;
+        }
+
+        if(largest == idx){
+            break;
+        }
+
+        swap_items(dynarr, base + idx, base + largest);
+        idx = largest;
+    }
+}
+
+// lomuto partition of [lo, hi] using the median of three as pivot
+static size_t partition(
+    DynArr *dynarr,
+    size_t lo,
+    size_t hi,
+    DynArrComparator comparator
+){
+    size_t middle = lo + (hi - lo) / 2;
+
+    if(comparator(get_slot(dynarr, middle), get_slot(dynarr, lo)) < 0){
+        swap_items(dynarr, middle, lo);
+    }
+
+    if(comparator(get_slot(dynarr, hi), get_slot(dynarr, lo)) < 0){
+        swap_items(dynarr, hi, lo);
+    }
+
+    if(comparator(get_slot(dynarr, middle), get_slot(dynarr, hi)) < 0){
+        swap_items(dynarr, middle, hi);
+    }
+
+    void *pivot = get_slot(dynarr, hi);
+    size_t store = lo;
+
+    for (size_t i = lo; i < hi; i++){
+        if(comparator(get_slot(dynarr, i), pivot) < 0){
+            swap_items(dynarr, i, store++);
+        }
+    }
+
+    swap_items(dynarr, store, hi);
+
+    return store;
+}
+
+// fallback of introselect once the partition depth limit is reached.
+// Keeps a max-heap of the smallest items in [lo, nth]
+static void heap_select(
+    DynArr *dynarr,
+    size_t lo,
+    size_t hi,
+    size_t nth,
+    DynArrComparator comparator
+){
+    size_t heap_len = nth - lo + 1;
+
+    for (size_t i = heap_len / 2; i-- > 0;){
+        heap_sift_down(dynarr, lo, heap_len, i, comparator);
+    }
+
+    for (size_t i = nth + 1; i <= hi; i++){
+        if(comparator(get_slot(dynarr, i), get_slot(dynarr, lo)) < 0){
+            swap_items(dynarr, i, lo);
+            heap_sift_down(dynarr, lo, heap_len, 0, comparator);
+        }
+    }
+
+    swap_items(dynarr, lo, nth);
+}
+
+// bottom-up merge sort of item indexes. Stable
+static void merge_sort_indexes(
+    const DynArr *dynarr,
+    size_t *indexes,
+    size_t *temp,
+    size_t len,
+    DynArrComparator comparator
+){
+    size_t *from = indexes;
+    size_t *to = temp;
+
+    for (size_t width = 1; width < len; width *= 2){
+        for (size_t lo = 0; lo < len; lo += width * 2){
+            size_t middle = lo + width < len ? lo + width : len;
+            size_t hi = lo + width * 2 < len ? lo + width * 2 : len;
+            size_t left = lo;
+            size_t right = middle;
+            size_t out = lo;
+
+            while (left < middle && right < hi){
+                if(comparator(get_slot(dynarr, from[right]), get_slot(dynarr, from[left])) < 0){
+                    to[out++] = from[right++];
+                }else{
+                    to[out++] = from[left++];
+                }
+            }
+
+            while (left < middle){
+                to[out++] = from[left++];
+            }
+
+            while (right < hi){
+                to[out++] = from[right++];
+            }
+        }
+
+        size_t *swap = from;
+        from = to;
+        to = swap;
+    }
+
+    if(from != indexes){
+        memcpy(indexes, from, sizeof(size_t) * len);
+    }
+}
+
+// chunk length in items, such that every chunk spans a whole number of
+// cache lines. With chunks starting on a line, see split_chunks, workers
+// never write to the same line
+static size_t chunk_items_for(size_t item_size){
+    size_t a = item_size;
+    size_t b = CACHE_LINE_SIZE;
+
+    while (b){
+        size_t r = a % b;
+        a = b;
+        b = r;
+    }
+
+    size_t unit = CACHE_LINE_SIZE / a;
+    size_t items = DYNARR_PARALLEL_CHUNK_BYTES / item_size;
+
+    return items < unit ? unit : items / unit * unit;
+}
+
+static void split_chunks(ParallelJob *job, const DynArr *written, size_t len){
+    size_t item_size = written->item_size;
+    size_t chunk_items = chunk_items_for(item_size);
+    size_t misalignment = written->items ? (uintptr_t)written->items % CACHE_LINE_SIZE : 0;
+    size_t first_chunk_items = chunk_items;
+
+    // items up to the first cache line boundary an item starts on. Some
+    // item sizes never meet one, then chunks just start at the items
+    if(misalignment > 0){
+        for (size_t i = 1; i < CACHE_LINE_SIZE; i++){
+            if((misalignment + i * item_size) % CACHE_LINE_SIZE == 0){
+                first_chunk_items = i;
+                break;
+            }
+        }
+    }
+
+    job->len = len;
+    job->first_chunk_items = first_chunk_items;
+    job->chunk_items = chunk_items;
+    job->chunk_count = len == 0 ? 0 :
+                       len <= first_chunk_items ? 1 :
+                       1 + (len - first_chunk_items + chunk_items - 1) / chunk_items;
+}
+
+static void run_chunks(ParallelJob *job, size_t self){
+    size_t participants = job->participants;
+
+    // own chunks first, then steal from the others
+    for (size_t i = 0; i < participants; i++){
+        ChunkRange *range = &job->ranges[(self + i) % participants];
+
+        while (1){
+            size_t chunk = atomic_fetch_add_explicit(&range->next, 1, memory_order_relaxed);
+
+            if(chunk >= range->end){
+                break;
+            }
+
+            size_t from = chunk == 0 ? 0 : job->first_chunk_items + (chunk - 1) * job->chunk_items;
+            size_t end = job->first_chunk_items + chunk * job->chunk_items;
+            size_t to = end < job->len ? end : job->len;
+
+            job->runner(job, chunk, from, to);
+        }
+    }
+}
+
+static void pool_run(DynArrPool *pool, ParallelJob *job){
+    size_t participants = 1;
+
+#ifdef DYNARR_POSIX
+    if(pool && job->len >= DYNARR_PARALLEL_THRESHOLD){
+        participants = pool->thread_count + 1;
+    }
+#endif
+
+    if(participants > job->chunk_count){
+        participants = job->chunk_count ? job->chunk_count : 1;
+    }
+
+    ChunkRange ranges[participants];
+    size_t per_participant = job->chunk_count / participants;
+    size_t remainder = job->chunk_count % participants;
+    size_t next = 0;
+
+    for (size_t i = 0; i < participants; i++){
+        size_t count = per_participant + (i < remainder);
+
+        atomic_init(&ranges[i].next, next);
+        ranges[i].end = next + count;
+        next += count;
+    }
+
+    job->participants = participants;
+    job->ranges = ranges;
+    atomic_init(&job->joined, 0);
+
+    if(participants == 1){
+        run_chunks(job, 0);
+        return;
+    }
+
+#ifdef DYNARR_POSIX
+    // workers past the participants count find nothing left to steal
+    pthread_mutex_lock(&pool->mutex);
+    pool->job = job;
+    pool->pending = pool->thread_count;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->work_cond);
+    pthread_mutex_unlock(&pool->mutex);
+
+    run_chunks(job, participants - 1);
+
+    pthread_mutex_lock(&pool->mutex);
+
+    while (pool->pending > 0){
+        pthread_cond_wait(&pool->done_cond, &pool->mutex);
+    }
+
+    pool->job = NULL;
+    pthread_mutex_unlock(&pool->mutex);
+#endif
+}
+
+#ifdef DYNARR_POSIX
+static void *pool_worker(void *raw_pool){
+    DynArrPool *pool = raw_pool;
+    size_t seen_generation = 0;
+
+    pthread_mutex_lock(&pool->mutex);
+
+    while (1){
+        while (!pool->stop && pool->generation == seen_generation){
+            pthread_cond_wait(&pool->work_cond, &pool->mutex);
+        }
+
+        if(pool->stop){
+            break;
+        }
+
+        ParallelJob *job = pool->job;
+
+        seen_generation = pool->generation;
+
+        pthread_mutex_unlock(&pool->mutex);
+
+        size_t self = atomic_fetch_add_explicit(&job->joined, 1, memory_order_relaxed);
+
+        run_chunks(job, self % job->participants);
+
+        pthread_mutex_lock(&pool->mutex);
+
+        if(--pool->pending == 0){
+            pthread_cond_signal(&pool->done_cond);
+        }
+    }
+
+    pthread_mutex_unlock(&pool->mutex);
+
+    return NULL;
+}
+#endif
+
+static void for_each_chunk(ParallelJob *job, size_t chunk, size_t from, size_t to){
+    (void)chunk;
+
+    for (size_t i = from; i < to; i++){
+        job->for_each(get_slot(job->dynarr, i), i, job->ctx);
+    }
+}
+
+static void map_chunk(ParallelJob *job, size_t chunk, size_t from, size_t to){
+    (void)chunk;
+
+    for (size_t i = from; i < to; i++){
+        job->mapper(get_slot(job->dynarr, i), get_slot(job->out, i), job->ctx);
+    }
+}
+
+static void reduce_chunk(ParallelJob *job, size_t chunk, size_t from, size_t to){
+    size_t item_size = job->dynarr->item_size;
+    char *acc = job->partials + chunk * item_size;
+
+    memcpy(acc, job->identity, item_size);
+
+    for (size_t i = from; i < to; i++){
+        job->combiner(acc, get_slot(job->dynarr, i), job->ctx);
+    }
+}
+
+// expects in 'partials' the combination of every item before the chunk
+static void scan_chunk(ParallelJob *job, size_t chunk, size_t from, size_t to){
+    size_t item_size = job->dynarr->item_size;
+    char acc[item_size];
+
+    memcpy(acc, job->partials + chunk * item_size, item_size);
+
+    for (size_t i = from; i < to; i++){
+        void *item = get_slot(job->dynarr, i);
+
+        job->combiner(acc, item, job->ctx);
+        memcpy(item, acc, item_size);
+    }
+}
+
+// a fixed pseudo random priority per node, the treap is a max-heap of
+// them and so stays balanced whatever the order of the edits
+static inline uint64_t batch_node_priority(size_t node){
+    uint64_t x = (uint64_t)node + UINT64_C(0x9E3779B97F4A7C15);
+
+    x = (x ^ (x >> 30)) * UINT64_C(0xBF58476D1CE4E5B9);
+    x = (x ^ (x >> 27)) * UINT64_C(0x94D049BB133111EB);
+
+    return x ^ (x >> 31);
+}
+
+static inline size_t batch_node_weight(const BatchNode *nodes, size_t node){
+    return node == NO_BATCH_NODE ? 0 : nodes[node].weight;
+}
+
+static inline void batch_node_update(BatchNode *nodes, size_t node){
+    BatchNode *current = &nodes[node];
+
+    current->weight = batch_node_weight(nodes, current->left) +
+                      current->segment.to - current->segment.from +
+                      batch_node_weight(nodes, current->right);
+}
+
+// joins two treaps, every position of 'left' going before 'right'
+static size_t batch_merge(BatchNode *nodes, size_t left, size_t right){
+    if(left == NO_BATCH_NODE){
+        return right;
+    }
+
+    if(right == NO_BATCH_NODE){
+        return left;
+    }
+
+    if(batch_node_priority(left) > batch_node_priority(right)){
+        nodes[left].right = batch_merge(nodes, nodes[left].right, right);
+        batch_node_update(nodes, left);
+
+        return left;
+    }
+
+    nodes[right].left = batch_merge(nodes, left, nodes[right].left);
+    batch_node_update(nodes, right);
+
+    return right;
+}
+
+// splits the treap at 'node' into its first 'pos' items and the rest.
+// A segment 'pos' falls inside of is cut in two, taking one more node
+// of the capacity reserved in 'nodes'
+static void batch_split(
+    DynArr *nodes,
+    size_t node,
+    size_t pos,
+    size_t *out_left,
+    size_t *out_right
+){
+    if(node == NO_BATCH_NODE){
+        *out_left = NO_BATCH_NODE;
+        *out_right = NO_BATCH_NODE;
+
+        return;
+    }
+
+    BatchNode *base = get_slot(nodes, 0);
+    BatchNode *current = &base[node];
+    size_t left_weight = batch_node_weight(base, current->left);
+    size_t segment_len = current->segment.to - current->segment.from;
+
+    if(pos <= left_weight){
+        batch_split(nodes, current->left, pos, out_left, &current->left);
+        batch_node_update(base, node);
+        *out_right = node;
+
+        return;
+    }
+
+    if(pos >= left_weight + segment_len){
+        batch_split(nodes, current->right, pos - left_weight - segment_len, &current->right, out_right);
+        batch_node_update(base, node);
+        *out_left = node;
+
+        return;
+    }
+
+    // only runs of original items are longer than one, so only those
+    // are ever cut
+    size_t offset = pos - left_weight;
+    size_t tail = nodes->used++;
+
+    base[tail] = (BatchNode){
+        .segment = {.from = current->segment.from + offset, .to = current->segment.to, .inserted = 0},
+        .weight = segment_len - offset,
+        .left = NO_BATCH_NODE,
+        .right = NO_BATCH_NODE
+    };
+
+    size_t right = current->right;
+
+    current->segment.to = current->segment.from + offset;
+    current->right = NO_BATCH_NODE;
+    batch_node_update(base, node);
+
+    *out_left = node;
+    *out_right = batch_merge(base, tail, right);
+}
+
+// applies 'edit' to the treap of segments describing an array of 'len'
+// items. Costs O(log segments), never touches the items themselves
+static int replay_edit(DynArr *nodes, size_t *root, size_t *len, const BatchEdit *edit){
+    size_t idx = edit->idx;
+    int is_insert = edit->item != SIZE_MAX;
+
+    if(is_insert ? idx > *len : idx >= *len){
+        return IDX_OUT_OF_BOUNDS_ERR_DYNARR_CODE;
+    }
+
+    size_t left;
+    size_t right;
+
+    batch_split(nodes, *root, idx, &left, &right);
+
+    BatchNode *base = get_slot(nodes, 0);
+
+    if(is_insert){
+        size_t inserted = nodes->used++;
+
+        base[inserted] = (BatchNode){
+            .segment = {.from = edit->item, .to = edit->item + 1, .inserted = 1},
+            .weight = 1,
+            .left = NO_BATCH_NODE,
+            .right = NO_BATCH_NODE
+        };
+
+        *root = batch_merge(base, batch_merge(base, left, inserted), right);
+        (*len)++;
+
+        return OK_DYNARR_CODE;
+    }
+
+    size_t removed;
+
+    // the removed item is left as a node nothing points to
+    batch_split(nodes, right, 1, &removed, &right);
+
+    *root = batch_merge(base, left, right);
+    (*len)--;
+
+    return OK_DYNARR_CODE;
+}
+
+// appends the segments of the treap at 'node' in position order
+static void flatten_segments(const BatchNode *nodes, size_t node, DynArr *segments){
+    if(node == NO_BATCH_NODE){
+        return;
+    }
+
+    flatten_segments(nodes, nodes[node].left, segments);
+
+    memcpy(get_slot(segments, segments->used++), &nodes[node].segment, sizeof(BatchSegment));
+
+    flatten_segments(nodes, nodes[node].right, segments);
+}
+
+// moves the original runs to their final position. Runs going left are
+// moved first to last and runs going right last to first, that way no
+// run overwrites items another run has not moved yet
+static void move_segments(
+    DynArr *dynarr,
+    const DynArr *segments,
+    size_t new_len,
+    int leftwards
+){
+    size_t segments_len = dynarr_len(segments);
+    size_t out_idx = leftwards ? 0 : new_len;
+
+    for (size_t n = 0; n < segments_len; n++){
+        size_t i = leftwards ? n : segments_len - 1 - n;
+        const BatchSegment *segment = get_slot(segments, i);
+        size_t segment_len = segment->to - segment->from;
+        size_t segment_out_idx = leftwards ? out_idx : out_idx - segment_len;
+
+        out_idx = leftwards ? out_idx + segment_len : out_idx - segment_len;
+
+        if(segment->inserted || (segment_out_idx <= segment->from) != leftwards){
+            continue;
+        }
+
+        if(segment_out_idx != segment->from){
+            memmove(
+                get_slot(dynarr, segment_out_idx),
+                get_slot(dynarr, segment->from),
+                segment_len * dynarr->item_size
+            );
+        }
+    }
+}
+
+// what empty payloads point to, as the arena may never have been
+// allocated or may be gone after a compaction
+static const char empty_payload[1];
+
+// every payload pointer handed out goes through here, never NULL
+static inline const void *var_payload(const DynArrVar *var, const VarEntry *entry){
+    if(entry->size == 0){
+        return empty_payload;
+    }
+
+    return var->bytes.items + entry->offset;
+}
+
+// same as merge_sort_indexes, but comparing the payloads of 'var'
+static void merge_sort_entries(
+    const DynArrVar *var,
+    VarEntry *entries,
+    VarEntry *temp,
+    size_t len,
+    DynArrVarComparator comparator
+){
+    VarEntry *from = entries;
+    VarEntry *to = temp;
+
+    for (size_t width = 1; width < len; width *= 2){
+        for (size_t lo = 0; lo < len; lo += width * 2){
+            size_t middle = lo + width < len ? lo + width : len;
+            size_t hi = lo + width * 2 < len ? lo + width * 2 : len;
+            size_t left = lo;
+            size_t right = middle;
+            size_t out = lo;
+
+            while (left < middle && right < hi){
+                const VarEntry *a = &from[right];
+                const VarEntry *b = &from[left];
+
+                if(comparator(var_payload(var, a), a->size, var_payload(var, b), b->size) < 0){
+                    to[out++] = from[right++];
+                }else{
+                    to[out++] = from[left++];
+                }
+            }
+
+            while (left < middle){
+                to[out++] = from[left++];
+            }
+
+            while (right < hi){
+                to[out++] = from[right++];
+            }
+        }
+
+        VarEntry *swap = from;
+        from = to;
+        to = swap;
+    }
+
+    if(from != entries){
+        memcpy(entries, from, sizeof(VarEntry) * len);
+    }
+}
+
+// copies the payloads, in item order, into an arena of exactly their size
+static int compact_arena(DynArrVar *var){
+    size_t len = dynarr_len(&var->entries);
+    size_t size = 0;
+
+    for (size_t i = 0; i < len; i++){
+        size += ((VarEntry *)get_slot(&var->entries, i))->size;
+    }
+
+    if(size == dynarr_len(&var->bytes)){
+        return 0;
+    }
+
+    DynArr bytes;
+
+    dynarr_init(&bytes, sizeof(char), var->bytes.allocator);
+
+    if(size > 0 && dynarr_reserve(&bytes, size)){
+        dynarr_deinit(&bytes);
+        return 1;
+    }
+
+    for (size_t i = 0; i < len; i++){
+        VarEntry *entry = get_slot(&var->entries, i);
+
+        // the new arena stays unallocated when only empty payloads remain
+        if(entry->size > 0){
+            memcpy(get_slot(&bytes, bytes.used), get_slot(&var->bytes, entry->offset), entry->size);
+        }
+
+        entry->offset = bytes.used;
+        bytes.used += entry->size;
+    }
+
+    // the registry links 'var->bytes' by address, so swap the buffers
+    // rather than the structs
+    char *items = var->bytes.items;
+    size_t items_offset = var->bytes.items_offset;
+    size_t capacity = var->bytes.capacity;
+
+    var->bytes.items = bytes.items;
+    var->bytes.items_offset = bytes.items_offset;
+    var->bytes.capacity = bytes.capacity;
+    var->bytes.used = bytes.used;
+
+    bytes.items = items;
+    bytes.items_offset = items_offset;
+    bytes.capacity = capacity;
+
+    dynarr_deinit(&bytes);
+
+    return 0;
+}
+
+// a power of two near log2(capacity), so windows split evenly
+static size_t pma_segment_len(size_t capacity){
+    size_t log = 0;
+    size_t segment_len = PMA_MIN_CAPACITY;
+
+    while (((size_t)1 << log) < capacity){
+        log++;
+    }
+
+    while (segment_len < log){
+        segment_len *= 2;
+    }
+
+    return segment_len < capacity ? segment_len : capacity;
+}
+
+static inline int pma_occupied(const DynArrPma *pma, size_t slot){
+    return ((const unsigned char *)pma->occupied.items)[slot];
+}
+
+// first occupied slot in [from, to), 'to' if none
+static size_t pma_next_occupied(const DynArrPma *pma, size_t from, size_t to){
+    while (from < to && !pma_occupied(pma, from)){
+        from++;
+    }
+
+    return from;
+}
+
+// binary search skipping over gaps. Returns a slot from which the next
+// occupied one holds the first item not less than 'item' (greater than,
+// with 'after_equals'), and in 'out_pred' the last occupied slot before
+// it, SIZE_MAX if none
+static size_t pma_search(
+    const DynArrPma *pma,
+    const void *item,
+    int after_equals,
+    size_t *out_pred
+){
+    size_t lo = 0;
+    size_t hi = pma->slots.capacity;
+    size_t pred = SIZE_MAX;
+
+    while (lo < hi){
+        size_t middle = lo + (hi - lo) / 2;
+        size_t slot = pma_next_occupied(pma, middle, hi);
+
+        if(slot == hi){
+            hi = middle;
+            continue;
+        }
+
+        int comparison = pma->comparator(get_slot(&pma->slots, slot), item);
+
+        if(comparison < 0 || (after_equals && comparison == 0)){
+            lo = slot + 1;
+            pred = slot;
+        }else{
+            hi = middle;
+        }
+    }
+
+    if(out_pred){
+        *out_pred = pred;
+    }
+
+    return lo;
+}
+
+static double pma_threshold(const DynArrPma *pma, size_t window_len, double leaf, double root){
+    size_t height = 0;
+    size_t levels = 0;
+
+    for (size_t len = pma->segment_len; len < window_len; len *= 2){
+        height++;
+    }
+
+    for (size_t len = pma->segment_len; len < pma->slots.capacity; len *= 2){
+        levels++;
+    }
+
+    if(levels == 0){
+        return leaf;
+    }
+
+    return leaf + (root - leaf) * (double)height / (double)levels;
+}
+
+static size_t pma_count(const DynArrPma *pma, size_t start, size_t window_len){
+    size_t count = 0;
+
+    for (size_t slot = start; slot < start + window_len; slot++){
+        count += pma_occupied(pma, slot);
+    }
+
+    return count;
+}
+
+// packs the items of the window at its start, returns how many
+static size_t pma_compact(DynArrPma *pma, size_t start, size_t window_len){
+    unsigned char *occupied = (unsigned char *)pma->occupied.items;
+    size_t item_size = pma->slots.item_size;
+    size_t count = 0;
+
+    for (size_t slot = start; slot < start + window_len; slot++){
+        if(!occupied[slot]){
+            continue;
+        }
+
+        size_t to = start + count++;
+
+        if(to != slot){
+            memcpy(get_slot(&pma->slots, to), get_slot(&pma->slots, slot), item_size);
+            occupied[slot] = 0;
+            occupied[to] = 1;
+        }
+    }
+
+    return count;
+}
+
+// evenly spaces the 'count' items packed at the window start. Right to
+// left, every item moves right, so none is overwritten
+static void pma_spread(DynArrPma *pma, size_t start, size_t window_len, size_t count){
+    unsigned char *occupied = (unsigned char *)pma->occupied.items;
+    size_t item_size = pma->slots.item_size;
+
+    for (size_t i = count; i-- > 0;){
+        size_t from = start + i;
+        size_t to = start + i * window_len / count;
+
+        if(to != from){
+            memcpy(get_slot(&pma->slots, to), get_slot(&pma->slots, from), item_size);
+            occupied[from] = 0;
+            occupied[to] = 1;
+        }
+    }
+}
+
+// items must be packed at the start when shrinking
+static int pma_resize(DynArrPma *pma, size_t capacity){
+    size_t old_capacity = pma->slots.capacity;
+
+    if(resize_items(&pma->slots, capacity) || resize_items(&pma->occupied, capacity)){
+        // keep both at the smaller size, the items fit in either
+        size_t min_capacity = pma->slots.capacity < pma->occupied.capacity ?
+                              pma->slots.capacity :
+                              pma->occupied.capacity;
+
+        resize_items(&pma->slots, min_capacity);
+        resize_items(&pma->occupied, min_capacity);
+
+        pma->slots.used = pma->slots.capacity;
+        pma->occupied.used = pma->occupied.capacity;
+        pma->segment_len = pma_segment_len(pma->slots.capacity);
+
+        return 1;
+    }
+
+    if(capacity > old_capacity){
+        memset((char *)pma->occupied.items + old_capacity, 0, capacity - old_capacity);
+    }
+
+    pma->slots.used = capacity;
+    pma->occupied.used = capacity;
+    pma->segment_len = pma_segment_len(capacity);
+
+    return 0;
+}
+
+// item 'idx' of a DynArr of uint32_t or uint64_t
+static inline uint64_t read_uint(const DynArr *dynarr, size_t idx){
+    if(dynarr->item_size == sizeof(uint32_t)){
+        return *(uint32_t *)get_slot(dynarr, idx);
+    }
+
+    return *(uint64_t *)get_slot(dynarr, idx);
+}
+
+static inline size_t bit_width(uint64_t value){
+    size_t width = 0;
+
+    while (value){
+        value >>= 1;
+        width++;
+    }
+
+    return width;
+}
+
+// 'words' must be zeroed
+static void pack_bits(uint64_t *words, size_t count, size_t width, const uint64_t *values){
+    for (size_t i = 0; i < count; i++){
+        size_t bit = i * width;
+        size_t word = bit / 64;
+        size_t shift = bit % 64;
+
+        words[word] |= values[i] << shift;
+
+        if(shift + width > 64){
+            words[word + 1] |= values[i] >> (64 - shift);
+        }
+    }
+}
+
+// writes every value of the block and returns how many there are
+static size_t decode_block(const DynArrPacked *packed, size_t block_idx, uint64_t *out_values){
+    const PackedBlock *block = get_slot(&packed->blocks, block_idx);
+    size_t block_len = block_idx + 1 < dynarr_len(&packed->blocks) ?
+                       PACKED_BLOCK_LEN :
+                       packed->len - block_idx * PACKED_BLOCK_LEN;
+    size_t width = block->width;
+    uint64_t value = block->first;
+
+    out_values[0] = value;
+
+    if(width == 0){
+        for (size_t i = 1; i < block_len; i++){
+            out_values[i] = value;
+        }
+
+        return block_len;
+    }
+
+    const uint64_t *words = (const uint64_t *)packed->words.items + block->word_offset;
+    uint64_t mask = width == 64 ? ~UINT64_C(0) : (UINT64_C(1) << width) - 1;
+
+    for (size_t i = 1; i < block_len; i++){
+        size_t bit = (i - 1) * width;
+        size_t word = bit / 64;
+        size_t shift = bit % 64;
+        uint64_t delta = words[word] >> shift;
+
+        if(shift + width > 64){
+            delta |= words[word + 1] << (64 - shift);
+        }
+
+        value += delta & mask;
+        out_values[i] = value;
+    }
+
+    return block_len;
+}
+
+// index of the first value not less than 'value', which goes in
+// 'out_found' when there is one
+static size_t packed_search(const DynArrPacked *packed, uint64_t value, uint64_t *out_found){
+    size_t blocks_len = dynarr_len(&packed->blocks);
+    size_t lo = 0;
+    size_t hi = blocks_len;
+
+    // first block starting at or above 'value'. Equal values can spill
+    // over from the block before, so that one is the one decoded
+    while (lo < hi){
+        size_t middle = lo + (hi - lo) / 2;
+        const PackedBlock *block = get_slot(&packed->blocks, middle);
+
+        if(block->first < value){
+            lo = middle + 1;
+        }else{
+            hi = middle;
+        }
+    }
+
+    if(lo > 0){
+        size_t block_idx = lo - 1;
+        uint64_t values[PACKED_BLOCK_LEN];
+        size_t block_len = decode_block(packed, block_idx, values);
+
+        for (size_t i = 0; i < block_len; i++){
+            if(values[i] >= value){
+                if(out_found){
+                    *out_found = values[i];
+                }
+
+                return block_idx * PACKED_BLOCK_LEN + i;
+            }
+        }
+    }
+
+    if(lo < blocks_len && out_found){
+        *out_found = ((const PackedBlock *)get_slot(&packed->blocks, lo))->first;
+    }
+
+    return lo * PACKED_BLOCK_LEN < packed->len ? lo * PACKED_BLOCK_LEN : packed->len;
+}
+
+static inline uint64_t *bits_words(const DynArrBits *bits){
+    return (uint64_t *)bits->words.items;
+}
+
+static inline void bits_clear_tail(DynArrBits *bits){
+    size_t tail = BITS_BIT_IDX(bits->len);
+
+    if(tail > 0){
+        bits_words(bits)[BITS_WORD_IDX(bits->len)] &= (UINT64_C(1) << tail) - 1;
+    }
+}
+
+// 'to' and 'from' may be the same bits. One plain loop per operation,
+// so compilers turn each into SIMD code
+static int bits_bulk_op(DynArrBits *to, const DynArrBits *from, BitsOp op){
+    if(to->len != from->len){
+        return SIZE_MISMATCH_ERR_DYNARR_CODE;
+    }
+
+    uint64_t *to_words = bits_words(to);
+    const uint64_t *from_words = bits_words(from);
+    size_t word_count = BITS_WORD_COUNT(to->len);
+
+    switch (op){
+        case AND_BITS_OP:
+            for (size_t i = 0; i < word_count; i++){
+                to_words[i] &= from_words[i];
+            }
+
+            break;
+        case OR_BITS_OP:
+            for (size_t i = 0; i < word_count; i++){
+                to_words[i] |= from_words[i];
+            }
+
+            break;
+        case XOR_BITS_OP:
+            for (size_t i = 0; i < word_count; i++){
+                to_words[i] ^= from_words[i];
+            }
+
+            break;
+    }
+
+    return OK_DYNARR_CODE;
+}
+
+static inline size_t popcount_word(uint64_t word){
+#if defined(__GNUC__)
+    return (size_t)__builtin_popcountll(word);
+#else
+    word = word - ((word >> 1) & UINT64_C(0x5555555555555555));
+    word = (word & UINT64_C(0x3333333333333333)) + ((word >> 2) & UINT64_C(0x3333333333333333));
+    word = (word + (word >> 4)) & UINT64_C(0x0f0f0f0f0f0f0f0f);
+
+    return (size_t)((word * UINT64_C(0x0101010101010101)) >> 56);
+#endif
+}
+
+// 'word' must not be zero
+static inline size_t ctz_word(uint64_t word){
+#if defined(__GNUC__)
+    return (size_t)__builtin_ctzll(word);
+#else
+    size_t count = 0;
+
+    while (!(word & 1)){
+        word >>= 1;
+        count++;
+    }
+
+    return count;
+#endif
+}
+
+// 'flip' set to all ones turns the search for set bits into a search
+// for clear bits
+static int bits_find_first(
+    const DynArrBits *bits,
+    size_t from,
+    uint64_t flip,
+    size_t *out_idx
+){
+    size_t len = bits->len;
+
+    if(from >= len){
+        return 0;
+    }
+
+    const uint64_t *words = bits_words(bits);
+    size_t word_count = BITS_WORD_COUNT(len);
+    size_t word_idx = BITS_WORD_IDX(from);
+    uint64_t word = (words[word_idx] ^ flip) & (~UINT64_C(0) << BITS_BIT_IDX(from));
+
+    while (1){
+        if(word){
+            size_t idx = word_idx * BITS_WORD_BITS + ctz_word(word);
+
+            if(idx >= len){
+                return 0;
+            }
+
+            *out_idx = idx;
+
+            return 1;
+        }
+
+        if(++word_idx >= word_count){
+            return 0;
+        }
+
+        word = words[word_idx] ^ flip;
+    }
+}
+
+// public implementation
+inline size_t dynarr_size(void){
+    return sizeof(DynArr);
+}
+
+DynArr *dynarr_init(void *raw_dynarr, size_t item_size, const DynArrAllocator *allocator){
+    DynArr *dynarr = raw_dynarr;
+
+    dynarr->used = 0;
+    dynarr->capacity = 0;
+    dynarr->item_size = item_size;
+    dynarr->items = NULL;
+    dynarr->alignment = 0;
+    dynarr->items_offset = 0;
+    dynarr->huge_pages = 0;
+    dynarr->share = NULL;
+    dynarr->persist = NULL;
+    dynarr->tracked = 0;
+    dynarr->allocator = allocator;
+
+    return dynarr;
+}
+
+DynArr *dynarr_create(const DynArrAllocator *allocator, size_t item_size){
+    DynArr *dynarr = MEMORY_ALLOC(DynArr, 1, allocator);
+
+    if(!dynarr){
+        return NULL;
+    }
+
+    dynarr->used = 0;
+    dynarr->capacity = 0;
+    dynarr->item_size = item_size;
+    dynarr->items = NULL;
+    dynarr->alignment = 0;
+    dynarr->items_offset = 0;
+    dynarr->huge_pages = 0;
+    dynarr->share = NULL;
+    dynarr->persist = NULL;
+    dynarr->tracked = 0;
+    dynarr->allocator = allocator;
+
+    track(dynarr);
+
+    return dynarr;
+}
+
+DynArr *dynarr_create_by(
+    const DynArrAllocator *allocator,
+    size_t item_size,
+    size_t item_count
+){
+    size_t by = item_count / DYNARR_DEFAULT_GROW_SIZE + 1;
+    size_t new_capacity = DYNARR_DEFAULT_GROW_SIZE * by;
+
+    if(item_size > 0 && new_capacity > SIZE_MAX / item_size){
+        return NULL;
+    }
+
+    if(charge_growth(NULL, item_size * new_capacity)){
+        return NULL;
+    }
+
+    void *items = MEMORY_ALLOC(char, item_size * new_capacity, allocator);
+    DynArr *dynarr = MEMORY_ALLOC(DynArr, 1, allocator);
+
+    if(!items || !dynarr){
+        charge_memory(item_size * new_capacity, 0);
+        MEMORY_DEALLOC(items, char, item_size * new_capacity, allocator);
+        MEMORY_DEALLOC(dynarr, DynArr, 1, allocator);
+
+        return NULL;
+    }
+
+    dynarr->used = 0;
+    dynarr->capacity = new_capacity;
+    dynarr->item_size = item_size;
+    dynarr->items = items;
+    dynarr->alignment = 0;
+    dynarr->items_offset = 0;
+    dynarr->huge_pages = 0;
+    dynarr->share = NULL;
+    dynarr->persist = NULL;
+    dynarr->tracked = 0;
+    dynarr->allocator = allocator;
+
+    track(dynarr);
+
+    return dynarr;
+}
+
+DynArr *dynarr_create_exact(
+    const DynArrAllocator *allocator,
+    size_t item_size,
+    size_t item_count
+){
+    DynArr *dynarr = dynarr_create(allocator, item_size);
+
+    if(!dynarr){
+        return NULL;
+    }
+
+    if(item_count > 0 && resize_items(dynarr, item_count)){
+        dynarr_destroy(dynarr);
+        return NULL;
+    }
+
+    return dynarr;
+}
+
+DynArr *dynarr_clone(DynArr *dynarr){
+    const DynArrAllocator *allocator = dynarr->allocator;
+    DynArr *clone = MEMORY_ALLOC(DynArr, 1, allocator);
+
+    if(!clone){
+        return NULL;
+    }
+
+    if(dynarr->items && !dynarr->share){
+        DynArrShare *share = MEMORY_ALLOC(DynArrShare, 1, allocator);
+
+        if(!share){
+            MEMORY_DEALLOC(clone, DynArr, 1, allocator);
+            return NULL;
+        }
+
+        share->refs = 1;
+        share->mapping = NULL;
+        share->mapping_size = 0;
+        dynarr->share = share;
+    }
+
+    *clone = *dynarr;
+    clone->persist = NULL;
+
+    track(clone);
+
+    if(clone->share){
+        clone->share->refs++;
+    }
+
+    return clone;
+}
+
+void dynarr_deinit(DynArr *dynarr){
+    if (!dynarr){
+        return;
+    }
+
+    untrack(dynarr);
+    persist_close(dynarr);
+    release_items(dynarr);
+}
+
+void dynarr_destroy(DynArr *dynarr){
+    if (!dynarr){
+        return;
+    }
+
+    const DynArrAllocator *allocator = dynarr->allocator;
+
+    untrack(dynarr);
+    persist_close(dynarr);
+    release_items(dynarr);
+    MEMORY_DEALLOC(
+        dynarr,
+        DynArr,
+        1,
+        allocator
+    );
+}
+
+inline size_t dynarr_len(const DynArr *dynarr){
+    return dynarr->used;
+}
+
+inline size_t dynarr_capacity(const DynArr *dynarr){
+    return dynarr->capacity;
+}
+
+inline size_t dynarr_item_size(const DynArr *dynarr){
+    return dynarr->item_size;
+}
+
+inline size_t dynarr_available(const DynArr *dynarr){
+    return dynarr->capacity - dynarr->used;
+}
+
+int dynarr_set_alignment(DynArr *dynarr, size_t alignment){
+    if(alignment == DYNARR_PAGE_ALIGNMENT){
+#ifdef DYNARR_POSIX
+        alignment = (size_t)sysconf(_SC_PAGESIZE);
+#else
+        alignment = 4096;
+#endif
+    }
+
+    if(alignment & (alignment - 1)){
+        return INCORRECT_SIZE_ERR_DYNARR_CODE;
+    }
+
+    if(alignment == dynarr->alignment){
+        return OK_DYNARR_CODE;
+    }
+
+    if(!dynarr->items){
+        dynarr->alignment = alignment;
+        return OK_DYNARR_CODE;
+    }
+
+    // move the items to a block with the new padding
+    size_t padding = alignment > 1 ? alignment - 1 : 0;
+    size_t raw_size = dynarr->capacity * dynarr->item_size + padding;
+
+    if(charge_growth(NULL, raw_size)){
+        return ALLOC_ERR_DYNARR_CODE;
+    }
+
+    // the pressure callback may have trimmed 'dynarr' meanwhile, the
+    // charge follows its capacity now, which can only be smaller
+    size_t capacity = dynarr->capacity;
+    size_t fit_size = capacity > 0 ? capacity * dynarr->item_size + padding : 0;
+
+    charge_memory(raw_size, fit_size);
+    raw_size = fit_size;
+
+    if(!dynarr->items){
+        dynarr->alignment = alignment;
+        return OK_DYNARR_CODE;
+    }
+
+    char *raw = MEMORY_ALLOC(char, raw_size, dynarr->allocator);
+
+    if(!raw){
+        charge_memory(raw_size, 0);
+        return ALLOC_ERR_DYNARR_CODE;
+    }
+
+    size_t items_offset = align_offset(raw, alignment);
+
+    memcpy(raw + items_offset, dynarr->items, dynarr->item_size * dynarr->used);
+    release_items(dynarr);
+
+    dynarr->items = raw + items_offset;
+    dynarr->items_offset = items_offset;
+    dynarr->alignment = alignment;
+    dynarr->share = NULL;
+
+    advise_huge_pages(dynarr);
+
+    return OK_DYNARR_CODE;
+}
+
+inline size_t dynarr_alignment(const DynArr *dynarr){
+    return dynarr->alignment;
+}
+
+void dynarr_set_huge_pages(DynArr *dynarr, int enabled){
+    dynarr->huge_pages = enabled;
+
+    advise_huge_pages(dynarr);
+}
+
+inline int dynarr_make_room(DynArr *dynarr, size_t count){
+    if(dynarr_available(dynarr) >= count){
+        return OK_DYNARR_CODE;
+    }
+
+    if(unshare_items(dynarr)){
+        return ALLOC_ERR_DYNARR_CODE;
+    }
+
+    size_t needed = dynarr_len(dynarr) + count;
+    size_t by = (needed + DYNARR_DEFAULT_GROW_SIZE - 1) / DYNARR_DEFAULT_GROW_SIZE;
+
+    return grow_by(dynarr, DYNARR_DEFAULT_GROW_SIZE * by) ? ALLOC_ERR_DYNARR_CODE : OK_DYNARR_CODE;
+}
+
+int dynarr_reserve(DynArr *dynarr, size_t total){
+    if(dynarr->capacity >= total){
+        return OK_DYNARR_CODE;
+    }
+
+    if(unshare_items(dynarr) || resize_items(dynarr, total)){
+        return ALLOC_ERR_DYNARR_CODE;
+    }
+
+    return OK_DYNARR_CODE;
+}
+
+int dynarr_shrink_to_fit(DynArr *dynarr){
+    if(dynarr->used == dynarr->capacity){
+        return OK_DYNARR_CODE;
+    }
+
+    if(unshare_items(dynarr) || fit_items(dynarr)){
+        return ALLOC_ERR_DYNARR_CODE;
+    }
+
+    return OK_DYNARR_CODE;
+}
+
+inline int dynarr_reduce(DynArr *dynarr){
+    if(dynarr_len(dynarr) < dynarr->capacity / 2){
+        if(unshare_items(dynarr)){
+            return 0;
+        }
+
+        return !shrink(dynarr);
+    }
+
+    return 0;
+}
+
+int dynarr_reverse(DynArr *dynarr){
+    if(prepare_write(dynarr, 0, dynarr_len(dynarr))){
+        return ALLOC_ERR_DYNARR_CODE;
+    }
+
+    size_t item_size = dynarr->item_size;
+    size_t len = dynarr_len(dynarr);
+    size_t until = dynarr_len(dynarr) / 2;
+
+    for (size_t left_index = 0; left_index < until; left_index++){
+        size_t right_index = len - 1 - left_index;
+        char *left = get_slot(dynarr, left_index);
+        char *right = get_slot(dynarr, right_index);
+        char temp_item[item_size];
+
+        memcpy(temp_item, left, item_size);
+        dynarr_set_at(dynarr, left_index, right);
+        dynarr_set_at(dynarr, right_index, temp_item);
+    }
+
+    return OK_DYNARR_CODE;
+}
+
+inline int dynarr_sort(DynArr *dynarr, DynArrComparator comparator){
+    if(prepare_write(dynarr, 0, dynarr_len(dynarr))){
+        return ALLOC_ERR_DYNARR_CODE;
+    }
+
+    qsort(dynarr->items, dynarr->used, dynarr->item_size, comparator);
+
+    return OK_DYNARR_CODE;
+}
+
+int dynarr_nth_element(DynArr *dynarr, size_t nth, DynArrComparator comparator){
+    size_t len = dynarr_len(dynarr);
+
+    if(nth >= len){
+        return IDX_OUT_OF_BOUNDS_ERR_DYNARR_CODE;
+    }
+
+    if(prepare_write(dynarr, 0, dynarr_len(dynarr))){
+        return ALLOC_ERR_DYNARR_CODE;
+    }
+
+    size_t lo = 0;
+    size_t hi = len - 1;
+    size_t depth_limit = 0;
+
+    for (size_t n = len; n > 1; n >>= 1){
+        depth_limit += 2;
+    }
+
+    while (lo < hi){
+        if(depth_limit-- == 0){
+            heap_select(dynarr, lo, hi, nth, comparator);
+            break;
+        }
+
+        size_t pivot_idx = partition(dynarr, lo, hi, comparator);
+
+        if(pivot_idx == nth){
+            break;
+        }
+
+        if(nth < pivot_idx){
+            hi = pivot_idx - 1;
+        }else{
+            lo = pivot_idx + 1;
+        }
+    }
+
+    return OK_DYNARR_CODE;
+}
+
+int dynarr_partial_sort(DynArr *dynarr, size_t k, DynArrComparator comparator){
+    size_t len = dynarr_len(dynarr);
+
+    if(k >= len){
+        return dynarr_sort(dynarr, comparator);
+    }
+
+    if(k == 0){
+        return OK_DYNARR_CODE;
+    }
+
+    if(dynarr_nth_element(dynarr, k - 1, comparator)){
+        return ALLOC_ERR_DYNARR_CODE;
+    }
+
+    qsort(dynarr->items, k - 1, dynarr->item_size, comparator);
+
+    return OK_DYNARR_CODE;
+}
+
+int dynarr_top_k_push(
+    DynArr *dynarr,
+    size_t k,
+    const void *item,
+    DynArrComparator comparator
+){
+    size_t len = dynarr_len(dynarr);
+
+    if(len < k){
+        if(dynarr_insert(dynarr, item)){
+            return ALLOC_ERR_DYNARR_CODE;
+        }
+
+        // the item climbs the parents of 'len' up to 'top', and only that
+        // path is taken as written
+        size_t top = len;
+
+        while (top > 0 && comparator(get_slot(dynarr, (top - 1) / 2), item) < 0){
+            top = (top - 1) / 2;
+        }
+
+        if(top < len && prepare_write(dynarr, top, len)){
+            dynarr->used = len;
+            return ALLOC_ERR_DYNARR_CODE;
+        }
+
+        for (size_t idx = len; idx > top; idx = (idx - 1) / 2){
+            swap_items(dynarr, (idx - 1) / 2, idx);
+        }
+
+        return OK_DYNARR_CODE;
+    }
+
+    // rejected items leave clones shared and persisted arrays clean
+    if(k == 0 || comparator(item, get_slot(dynarr, 0)) >= 0){
+        return OK_DYNARR_CODE;
+    }
+
+    // the item sinks from the root along the larger children, one bit
+    // per level telling right from left, down to 'last'
+    uint64_t turns = 0;
+    size_t depth = 0;
+    size_t last = 0;
+
+    while (last * 2 + 1 < len){
+        size_t left = last * 2 + 1;
+        size_t child = left;
+
+        if(left + 1 < len && comparator(get_slot(dynarr, left + 1), get_slot(dynarr, left)) > 0){
+            child = left + 1;
+        }
+
+        if(comparator(get_slot(dynarr, child), item) <= 0){
+            break;
+        }
+
+        turns |= (uint64_t)(child - left) << depth++;
+        last = child;
+    }
+
+    if(prepare_write(dynarr, 0, last + 1)){
+        return ALLOC_ERR_DYNARR_CODE;
+    }
+
+    memmove(get_slot(dynarr, 0), item, dynarr->item_size);
+
+    for (size_t level = 0, idx = 0; level < depth; level++){
+        size_t child = idx * 2 + 1 + ((turns >> level) & 1);
+
+        swap_items(dynarr, idx, child);
+        idx = child;
+    }
+
+    return OK_DYNARR_CODE;
+}
+
+int dynarr_top_k_sort(DynArr *dynarr, DynArrComparator comparator){
+    if(prepare_write(dynarr, 0, dynarr_len(dynarr))){
+        return ALLOC_ERR_DYNARR_CODE;
+    }
+
+    size_t len = dynarr_len(dynarr);
+
+    for (size_t i = len / 2; i-- > 0;){
+        heap_sift_down(dynarr, 0, len, i, comparator);
+    }
+
+    for (size_t heap_len = len; heap_len > 1; heap_len--){
+        swap_items(dynarr, 0, heap_len - 1);
+        heap_sift_down(dynarr, 0, heap_len - 1, 0, comparator);
+    }
+
+    return OK_DYNARR_CODE;
+}
+
+int dynarr_argsort(
+    const DynArrAllocator *allocator,
+    const DynArr *dynarr,
+    DynArrComparator comparator,
+    DynArr **out_indexes
+){
+    size_t len = dynarr_len(dynarr);
+
+    // nothing to sort, and no zero sized scratch to ask the allocator for
+    if(len == 0){
+        DynArr *indexes = dynarr_create(allocator, sizeof(size_t));
+
+        if(!indexes){
+            return ALLOC_ERR_DYNARR_CODE;
+        }
+
+        *out_indexes = indexes;
+
+        return OK_DYNARR_CODE;
+    }
+
+    DynArr *indexes = dynarr_create_by(allocator, sizeof(size_t), len);
+    size_t *temp = MEMORY_ALLOC(size_t, len, allocator);
+
+    if(!indexes || !temp){
+        dynarr_destroy(indexes);
+        MEMORY_DEALLOC(temp, size_t, len, allocator);
+
+        return ALLOC_ERR_DYNARR_CODE;
+    }
+
+    size_t *raw_indexes = (size_t *)indexes->items;
+
+    for (size_t i = 0; i < len; i++){
+        raw_indexes[i] = i;
+    }
+
+    merge_sort_indexes(dynarr, raw_indexes, temp, len, comparator);
+    MEMORY_DEALLOC(temp, size_t, len, allocator);
+
+    indexes->used = len;
+    *out_indexes = indexes;
+
+    return OK_DYNARR_CODE;
+}
+
+int dynarr_sort_by_key(
+    DynArr *dynarr,
+    size_t key_size,
+    DynArrKeyExtractor extractor,
+    DynArrComparator key_comparator
+){
+    size_t len = dynarr_len(dynarr);
+    size_t item_size = dynarr->item_size;
+    // each entry is the key followed by the index of its item
+    size_t idx_offset = (key_size + sizeof(size_t) - 1) / sizeof(size_t) * sizeof(size_t);
+    size_t entry_size = idx_offset + sizeof(size_t);
+
+    if(len < 2){
+        return OK_DYNARR_CODE;
+    }
+
+    if(prepare_write(dynarr, 0, dynarr_len(dynarr))){
+        return ALLOC_ERR_DYNARR_CODE;
+    }
+
+    char *entries = MEMORY_ALLOC(char, entry_size * len, dynarr->allocator);
+
+    if(!entries){
+        return ALLOC_ERR_DYNARR_CODE;
+    }
+
+    #define ENTRY_IDX(_i) (*(size_t *)(entries + (_i) * entry_size + idx_offset))
+
+    for (size_t i = 0; i < len; i++){
+        extractor(get_slot(dynarr, i), entries + i * entry_size);
+        ENTRY_IDX(i) = i;
+    }
+
+    qsort(entries, len, entry_size, key_comparator);
+
+    // apply the permutation following its cycles, so every item is
+    // copied once into its final slot
+    char temp_item[item_size];
+
+    for (size_t i = 0; i < len; i++){
+        if(ENTRY_IDX(i) == i){
+            continue;
+        }
+
+        size_t current = i;
+
+        memcpy(temp_item, get_slot(dynarr, i), item_size);
+
+        while (1){
+            size_t source = ENTRY_IDX(current);
+
+            ENTRY_IDX(current) = current;
+
+            if(source == i){
+                memcpy(get_slot(dynarr, current), temp_item, item_size);
+                break;
+            }
+
+            memcpy(get_slot(dynarr, current), get_slot(dynarr, source), item_size);
+            current = source;
+        }
+    }
+
+    #undef ENTRY_IDX
+
+    MEMORY_DEALLOC(entries, char, entry_size * len, dynarr->allocator);
+
+    return OK_DYNARR_CODE;
+}
+
+int dynarr_find(const DynArr *dynarr, const void *item, DynArrComparator comparator){
+    size_t len = dynarr_len(dynarr);
+    int low = 0;
+    int high = len == 0 ? 0 : len - 1;
+
+    while (low <= high){
+        int middle_index = low + (high - low) / 2;
+        void *middle = get_slot(dynarr, (size_t)middle_index);
+        int comparison = comparator(middle, item);
+
+        if(comparison < 0){
+            low = middle_index + 1;
+        }else if(comparison > 0){
+            high = middle_index - 1;
+        }else{
+            return middle_index;
+        }
+    }
+
+    return -1;
+}
 
 inline void *dynarr_get_raw(const DynArr *dynarr, size_t idx){
     if(idx >= dynarr_len(dynarr)){
         return NULL;
     }
 
-    return get_slot(dynarr, idx);
+    return get_slot(dynarr, idx);
+}
+
+inline void *dynarr_get_ptr(const DynArr *dynarr, size_t idx){
+    if(idx >= dynarr_len(dynarr)){
+        return NULL;
+    }
+
+    return (void *)(*(uintptr_t *)get_slot(dynarr, idx));
+}
+
+inline int dynarr_set_at(DynArr *dynarr, size_t idx, const void *item){
+    if(idx >= dynarr_len(dynarr)){
+        return IDX_OUT_OF_BOUNDS_ERR_DYNARR_CODE;
+    }
+
+    if(prepare_write(dynarr, idx, idx + 1)){
+        return ALLOC_ERR_DYNARR_CODE;
+    }
+
+    memmove(get_slot(dynarr, idx), item, dynarr->item_size);
+
+    return OK_DYNARR_CODE;
+}
+
+inline int dynarr_set_ptr(DynArr *dynarr, size_t idx, const void *ptr){
+    if(idx >= dynarr_len(dynarr)){
+        return IDX_OUT_OF_BOUNDS_ERR_DYNARR_CODE;
+    }
+
+    if(prepare_write(dynarr, idx, idx + 1)){
+        return ALLOC_ERR_DYNARR_CODE;
+    }
+
+    size_t rsize = dynarr->item_size;
+    uintptr_t iptr = (uintptr_t)ptr;
+
+    memmove(get_slot(dynarr, idx), &iptr, rsize);
+
+    return OK_DYNARR_CODE;
+}
+
+inline int dynarr_insert(DynArr *dynarr, const void *item){
+    if(prepare_write(dynarr, dynarr->used, dynarr->used + 1)){
+        return ALLOC_ERR_DYNARR_CODE;
+    }
+
+    if (dynarr->used >= dynarr->capacity && grow(dynarr)){
+        return ALLOC_ERR_DYNARR_CODE;
+    }
+
+    memmove(get_slot(dynarr, dynarr->used++), item, dynarr->item_size);
+
+    return OK_DYNARR_CODE;
+}
+
+int dynarr_insert_at(DynArr *dynarr, size_t idx, const void *item){
+    size_t len = dynarr_len(dynarr);
+
+    if(idx > len){
+        return IDX_OUT_OF_BOUNDS_ERR_DYNARR_CODE;
+    }
+
+    if(prepare_write(dynarr, idx, len + 1)){
+        return ALLOC_ERR_DYNARR_CODE;
+    }
+
+    if(dynarr_available(dynarr) == 0 && grow(dynarr)){
+        return ALLOC_ERR_DYNARR_CODE;
+    }
+
+    move_items(dynarr, idx, idx + 1);
+    memmove(get_slot(dynarr, idx), item, dynarr->item_size);
+
+    dynarr->used++;
+
+    return OK_DYNARR_CODE;
+}
+
+inline int dynarr_insert_ptr(DynArr *dynarr, const void *ptr){
+    if(dynarr->item_size != sizeof(uintptr_t)){
+        return INCORRECT_SIZE_ERR_DYNARR_CODE;
+    }
+
+    uintptr_t iptr = (uintptr_t)ptr;
+
+    return dynarr_insert(dynarr, &iptr);
+}
+
+inline int dynarr_insert_ptr_at(DynArr *dynarr, size_t idx, const void *ptr){
+    if(dynarr->item_size != sizeof(uintptr_t)){
+        return INCORRECT_SIZE_ERR_DYNARR_CODE;
+    }
+
+    uintptr_t iptr = (uintptr_t)ptr;
+
+    return dynarr_insert_at(dynarr, idx, &iptr);
+}
+
+int dynarr_append(DynArr *to, const DynArr *from){
+    size_t from_len = dynarr_len(from);
+
+    if(from_len == 0){
+        return DYNARR_EMPTY_ERR_DYNARR_CODE;
+    }
+
+    if(prepare_write(to, dynarr_len(to), dynarr_len(to) + from_len)){
+        return ALLOC_ERR_DYNARR_CODE;
+    }
+
+    size_t to_len = dynarr_len(to);
+    size_t to_available = dynarr_available(to);
+    size_t to_start_idx = to_len;
+
+    if(from_len <= to_available){
+        memmove(
+            get_slot(to, to_start_idx),
+            get_slot(from, 0),
+            from->item_size * from_len
+        );
+
+        to->used += from_len;
+
+        return OK_DYNARR_CODE;
+    }
+
+    if(dynarr_make_room(to, from_len)){
+        return ALLOC_ERR_DYNARR_CODE;
+    }
+
+    memmove(
+        get_slot(to, to_start_idx),
+        get_slot(from, 0),
+        from->item_size * from_len
+    );
+
+    to->used += from_len;
+
+    return OK_DYNARR_CODE;
+}
+
+int dynarr_join(
+    const DynArrAllocator *allocator,
+    const DynArr *a_dynarr,
+    const DynArr *b_dynarr,
+    DynArr **out_new_dynarr
+){
+    size_t a_item_size = a_dynarr->item_size;
+    size_t b_item_size = b_dynarr->item_size;
+
+    if(a_item_size != b_item_size){
+        return SIZE_MISMATCH_ERR_DYNARR_CODE;
+    }
+
+    #define ITEM_SIZE a_item_size
+
+    size_t a_len = dynarr_len(a_dynarr);
+    size_t b_len = dynarr_len(b_dynarr);
+    size_t c_len = a_len + b_len;
+    size_t by = c_len / DYNARR_DEFAULT_GROW_SIZE + 1;
+    DynArr *c_dynarr = dynarr_create(allocator, ITEM_SIZE);
+
+    if(!c_dynarr){
+        return ALLOC_ERR_DYNARR_CODE;
+    }
+
+    // the result is laid out like 'a_dynarr'
+    c_dynarr->alignment = a_dynarr->alignment;
+    c_dynarr->huge_pages = a_dynarr->huge_pages;
+
+    if(grow_by(c_dynarr, DYNARR_DEFAULT_GROW_SIZE * by)){
+        dynarr_destroy(c_dynarr);
+        return ALLOC_ERR_DYNARR_CODE;
+    }
+
+    memcpy(c_dynarr->items, a_dynarr->items, ITEM_SIZE * a_len);
+    memcpy(get_slot(c_dynarr, a_len), b_dynarr->items, ITEM_SIZE * b_len);
+
+    c_dynarr->used = c_len;
+    *out_new_dynarr = c_dynarr;
+
+    return OK_DYNARR_CODE;
+}
+
+inline int dynarr_remove_index(DynArr *dynarr, size_t idx){
+    size_t len = dynarr_len(dynarr);
+
+    if(idx >= len){
+        return IDX_OUT_OF_BOUNDS_ERR_DYNARR_CODE;
+    }
+
+    if(prepare_write(dynarr, idx, len)){
+        return ALLOC_ERR_DYNARR_CODE;
+    }
+
+    if(idx < len - 1){
+        move_items(dynarr, idx + 1, idx);
+    }
+
+    dynarr->used--;
+
+    return OK_DYNARR_CODE;
+}
+
+inline int dynarr_swap_remove(DynArr *dynarr, size_t idx){
+    size_t len = dynarr_len(dynarr);
+
+    if(idx >= len){
+        return IDX_OUT_OF_BOUNDS_ERR_DYNARR_CODE;
+    }
+
+    if(idx < len - 1){
+        if(prepare_write(dynarr, idx, idx + 1)){
+            return ALLOC_ERR_DYNARR_CODE;
+        }
+
+        memcpy(get_slot(dynarr, idx), get_slot(dynarr, len - 1), dynarr->item_size);
+    }
+
+    dynarr->used--;
+
+    return OK_DYNARR_CODE;
+}
+
+inline int dynarr_pop(DynArr *dynarr, void *out_item){
+    size_t len = dynarr_len(dynarr);
+
+    if(len == 0){
+        return DYNARR_EMPTY_ERR_DYNARR_CODE;
+    }
+
+    if(out_item){
+        memcpy(out_item, get_slot(dynarr, len - 1), dynarr->item_size);
+    }
+
+    dynarr->used--;
+
+    return OK_DYNARR_CODE;
+}
+
+int dynarr_swap_remove_many(DynArr *dynarr, const DynArr *idxs){
+    if(idxs->item_size != sizeof(size_t)){
+        return INCORRECT_SIZE_ERR_DYNARR_CODE;
+    }
+
+    size_t len = dynarr_len(dynarr);
+    size_t idxs_len = dynarr_len(idxs);
+
+    for (size_t i = 0; i < idxs_len; i++){
+        if(*(size_t *)get_slot(idxs, i) >= len){
+            return IDX_OUT_OF_BOUNDS_ERR_DYNARR_CODE;
+        }
+    }
+
+    if(idxs_len == 0){
+        return OK_DYNARR_CODE;
+    }
+
+    size_t *sorted = MEMORY_ALLOC(size_t, idxs_len, dynarr->allocator);
+
+    if(!sorted){
+        return ALLOC_ERR_DYNARR_CODE;
+    }
+
+    memcpy(sorted, idxs->items, sizeof(size_t) * idxs_len);
+    qsort(sorted, idxs_len, sizeof(size_t), compare_idxs_desc);
+
+    // from the highest index down, the last item is never one that
+    // still has to be removed
+    for (size_t i = 0; i < idxs_len; i++){
+        if(i > 0 && sorted[i] == sorted[i - 1]){
+            continue;
+        }
+
+        if(dynarr_swap_remove(dynarr, sorted[i])){
+            MEMORY_DEALLOC(sorted, size_t, idxs_len, dynarr->allocator);
+            return ALLOC_ERR_DYNARR_CODE;
+        }
+    }
+
+    MEMORY_DEALLOC(sorted, size_t, idxs_len, dynarr->allocator);
+
+    return OK_DYNARR_CODE;
+}
+
+int dynarr_remove_if(DynArr *dynarr, DynArrPredicate predicate, void *ctx){
+    if(unshare_items(dynarr)){
+        return 0;
+    }
+
+    size_t i = 0;
+    size_t remove_count  = 0;
+
+    while (i < dynarr_len(dynarr)){
+        void *item = dynarr_get_raw(dynarr, i);
+
+        if(predicate(item, ctx)){
+            dynarr_remove_index(dynarr, i);
+
+            remove_count++;
+        }else{
+            i++;
+        }
+    }
+
+    return remove_count;
+}
+
+inline void dynarr_remove_all(DynArr *dynarr){
+    dynarr->used = 0;
+}
+
+int dynarr_save(const DynArr *dynarr, const char *path){
+    size_t items_size = dynarr->item_size * dynarr_len(dynarr);
+    DynArrFileHeader header = {
+        .magic = DYNARR_FILE_MAGIC,
+        .version = DYNARR_FILE_VERSION,
+        .item_size = dynarr->item_size,
+        .len = dynarr_len(dynarr),
+        .checksum = checksum(dynarr->items, items_size)
+    };
+    FILE *file = fopen(path, "wb");
+
+    if(!file){
+        return IO_ERR_DYNARR_CODE;
+    }
+
+    int failed = fwrite(&header, sizeof(header), 1, file) != 1 ||
+                 (items_size > 0 && fwrite(dynarr->items, items_size, 1, file) != 1);
+
+    failed |= fclose(file) != 0;
+
+    return failed ? IO_ERR_DYNARR_CODE : OK_DYNARR_CODE;
+}
+
+int dynarr_load(const DynArrAllocator *allocator, const char *path, DynArr **out_dynarr){
+    DynArrFileHeader header;
+    FILE *file = fopen(path, "rb");
+
+    if(!file){
+        return IO_ERR_DYNARR_CODE;
+    }
+
+    if(fread(&header, sizeof(header), 1, file) != 1){
+        fclose(file);
+        return FORMAT_ERR_DYNARR_CODE;
+    }
+
+    // a header claiming more items than the file holds must be refused
+    // before anything is allocated for them
+    uint64_t available_size = UINT64_MAX;
+
+#ifdef DYNARR_POSIX
+    struct stat file_stat;
+
+    if(fstat(fileno(file), &file_stat) == -1){
+        fclose(file);
+        return IO_ERR_DYNARR_CODE;
+    }
+
+    if((uint64_t)file_stat.st_size < sizeof(DynArrFileHeader)){
+        fclose(file);
+        return FORMAT_ERR_DYNARR_CODE;
+    }
+
+    available_size = (uint64_t)file_stat.st_size - sizeof(DynArrFileHeader);
+#endif
+
+    int code = check_header(&header, available_size);
+
+    if(code){
+        fclose(file);
+        return code;
+    }
+
+    size_t len = (size_t)header.len;
+    size_t items_size = (size_t)header.item_size * len;
+    DynArr *dynarr = dynarr_create_exact(allocator, (size_t)header.item_size, len);
+
+    if(!dynarr){
+        fclose(file);
+        return ALLOC_ERR_DYNARR_CODE;
+    }
+
+    if(items_size > 0 && fread(dynarr->items, items_size, 1, file) != 1){
+        code = FORMAT_ERR_DYNARR_CODE;
+    }else if(checksum(dynarr->items, items_size) != header.checksum){
+        code = FORMAT_ERR_DYNARR_CODE;
+    }
+
+    fclose(file);
+
+    if(code){
+        dynarr_destroy(dynarr);
+        return code;
+    }
+
+    dynarr->used = len;
+    *out_dynarr = dynarr;
+
+    return OK_DYNARR_CODE;
+}
+
+int dynarr_map_readonly(const DynArrAllocator *allocator, const char *path, DynArr **out_dynarr){
+#ifdef DYNARR_POSIX
+    int fd = open(path, O_RDONLY);
+    struct stat file_stat;
+
+    if(fd == -1){
+        return IO_ERR_DYNARR_CODE;
+    }
+
+    if(fstat(fd, &file_stat) == -1){
+        close(fd);
+        return IO_ERR_DYNARR_CODE;
+    }
+
+    size_t mapping_size = (size_t)file_stat.st_size;
+
+    if(mapping_size < sizeof(DynArrFileHeader)){
+        close(fd);
+        return FORMAT_ERR_DYNARR_CODE;
+    }
+
+    void *mapping = mmap(NULL, mapping_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    close(fd);
+
+    if(mapping == MAP_FAILED){
+        return IO_ERR_DYNARR_CODE;
+    }
+
+    const DynArrFileHeader *header = mapping;
+    // the checksum is not verified, that would mean reading every page
+    int code = check_header(header, mapping_size - sizeof(DynArrFileHeader));
+    DynArr *dynarr = NULL;
+    DynArrShare *share = NULL;
+
+    if(!code){
+        dynarr = MEMORY_ALLOC(DynArr, 1, allocator);
+        share = MEMORY_ALLOC(DynArrShare, 1, allocator);
+        code = dynarr && share ? OK_DYNARR_CODE : ALLOC_ERR_DYNARR_CODE;
+    }
+
+    if(code){
+        MEMORY_DEALLOC(dynarr, DynArr, 1, allocator);
+        MEMORY_DEALLOC(share, DynArrShare, 1, allocator);
+        munmap(mapping, mapping_size);
+
+        return code;
+    }
+
+    share->refs = 1;
+    share->mapping = mapping;
+    share->mapping_size = mapping_size;
+
+    dynarr->used = (size_t)header->len;
+    dynarr->capacity = (size_t)header->len;
+    dynarr->item_size = (size_t)header->item_size;
+    dynarr->items = (char *)mapping + sizeof(DynArrFileHeader);
+    dynarr->alignment = 0;
+    dynarr->items_offset = 0;
+    dynarr->huge_pages = 0;
+    dynarr->share = share;
+    dynarr->persist = NULL;
+    dynarr->tracked = 0;
+    dynarr->allocator = allocator;
+
+    track(dynarr);
+
+    *out_dynarr = dynarr;
+
+    return OK_DYNARR_CODE;
+#else
+    (void)allocator;
+    (void)path;
+    (void)out_dynarr;
+
+    return IO_ERR_DYNARR_CODE;
+#endif
+}
+
+#ifdef DYNARR_POSIX
+static int write_at(int fd, const char *bytes, size_t size, off_t offset){
+    while (size > 0){
+        ssize_t written = pwrite(fd, bytes, size, offset);
+
+        if(written < 0){
+            return 1;
+        }
+
+        bytes += written;
+        size -= (size_t)written;
+        offset += written;
+    }
+
+    return 0;
+}
+
+static int read_at(int fd, char *bytes, size_t size, off_t offset){
+    while (size > 0){
+        ssize_t got = pread(fd, bytes, size, offset);
+
+        if(got <= 0){
+            return 1;
+        }
+
+        bytes += got;
+        size -= (size_t)got;
+        offset += got;
+    }
+
+    return 0;
+}
+
+static int compare_ranges(const void *a, const void *b){
+    size_t a_from = ((const DirtyRange *)a)->from;
+    size_t b_from = ((const DirtyRange *)b)->from;
+
+    return (a_from > b_from) - (a_from < b_from);
+}
+#endif
+
+int dynarr_persist_open(
+    const DynArrAllocator *allocator,
+    const char *path,
+    size_t item_size,
+    DynArr **out_dynarr
+){
+#ifdef DYNARR_POSIX
+    int fd = open(path, O_RDWR | O_CREAT, 0644);
+    struct stat file_stat;
+    DynArrFileHeader header = {
+        .magic = DYNARR_FILE_MAGIC,
+        .version = DYNARR_FILE_VERSION,
+        .item_size = item_size,
+        .len = 0,
+        .checksum = DYNARR_CHECKSUM_SEED
+    };
+
+    if(fd == -1){
+        return IO_ERR_DYNARR_CODE;
+    }
+
+    if(fstat(fd, &file_stat) == -1){
+        close(fd);
+        return IO_ERR_DYNARR_CODE;
+    }
+
+    size_t file_size = (size_t)file_stat.st_size;
+    int code = OK_DYNARR_CODE;
+
+    if(file_size == 0){
+        if(write_at(fd, (const char *)&header, sizeof(header), 0) || fdatasync(fd)){
+            code = IO_ERR_DYNARR_CODE;
+        }
+    }else if(file_size < sizeof(header) || read_at(fd, (char *)&header, sizeof(header), 0)){
+        code = FORMAT_ERR_DYNARR_CODE;
+    }else if(!(code = check_header(&header, file_size - sizeof(header))) &&
+             header.item_size != item_size){
+        code = SIZE_MISMATCH_ERR_DYNARR_CODE;
+    }
+
+    if(code){
+        close(fd);
+        return code;
+    }
+
+    size_t len = (size_t)header.len;
+    size_t items_size = item_size * len;
+    size_t words_size = items_size / sizeof(uint64_t) * sizeof(uint64_t);
+    DynArr *dynarr = dynarr_create_by(allocator, item_size, len);
+    DynArrPersist *persist = MEMORY_ALLOC(DynArrPersist, 1, allocator);
+    uint64_t hash = DYNARR_CHECKSUM_SEED;
+
+    if(!dynarr || !persist){
+        code = ALLOC_ERR_DYNARR_CODE;
+    }else if(read_at(fd, dynarr->items, items_size, sizeof(header))){
+        code = FORMAT_ERR_DYNARR_CODE;
+    }else{
+        hash = checksum_words(hash, dynarr->items, words_size / sizeof(uint64_t));
+
+        if(checksum_bytes(hash, dynarr->items + words_size, items_size - words_size) != header.checksum){
+            code = FORMAT_ERR_DYNARR_CODE;
+        }
+    }
+
+    if(code){
+        dynarr_destroy(dynarr);
+        MEMORY_DEALLOC(persist, DynArrPersist, 1, allocator);
+        close(fd);
+
+        return code;
+    }
+
+    persist->fd = fd;
+    persist->published_len = len;
+    persist->hash = hash;
+    persist->hashed_size = words_size;
+    init_tracked(&persist->ranges, sizeof(DirtyRange), allocator);
+
+    dynarr->used = len;
+    dynarr->persist = persist;
+    *out_dynarr = dynarr;
+
+    return OK_DYNARR_CODE;
+#else
+    (void)allocator;
+    (void)path;
+    (void)item_size;
+    (void)out_dynarr;
+
+    return IO_ERR_DYNARR_CODE;
+#endif
+}
+
+int dynarr_persist_flush(DynArr *dynarr){
+    DynArrPersist *persist = dynarr->persist;
+
+    if(!persist){
+        return OK_DYNARR_CODE;
+    }
+
+#ifdef DYNARR_POSIX
+    DynArr *ranges = &persist->ranges;
+    size_t ranges_len = dynarr_len(ranges);
+    size_t len = dynarr_len(dynarr);
+    size_t item_size = dynarr->item_size;
+    size_t first_dirty = len;
+
+    if(ranges_len == 0 && len == persist->published_len){
+        return OK_DYNARR_CODE;
+    }
+
+    qsort(ranges->items, ranges_len, sizeof(DirtyRange), compare_ranges);
+
+    // write the dirty ranges, merging the ones that touch
+    for (size_t i = 0; i < ranges_len;){
+        DirtyRange range = *(DirtyRange *)get_slot(ranges, i++);
+
+        while (i < ranges_len && ((DirtyRange *)get_slot(ranges, i))->from <= range.to){
+            DirtyRange *next = get_slot(ranges, i++);
+
+            range.to = next->to > range.to ? next->to : range.to;
+        }
+
+        range.to = range.to < len ? range.to : len;
+
+        if(range.from >= range.to){
+            continue;
+        }
+
+        first_dirty = range.from < first_dirty ? range.from : first_dirty;
+
+        if(write_at(
+            persist->fd,
+            get_slot(dynarr, range.from),
+            (range.to - range.from) * item_size,
+            (off_t)(sizeof(DynArrFileHeader) + range.from * item_size)
+        )){
+            return IO_ERR_DYNARR_CODE;
+        }
+    }
+
+    // items must be durable before the header publishes them
+    if(fdatasync(persist->fd)){
+        return IO_ERR_DYNARR_CODE;
+    }
+
+    size_t items_size = len * item_size;
+    size_t words_size = items_size / sizeof(uint64_t) * sizeof(uint64_t);
+
+    // only appends can resume the previous checksum state
+    if(first_dirty * item_size < persist->hashed_size || items_size < persist->hashed_size){
+        persist->hash = DYNARR_CHECKSUM_SEED;
+        persist->hashed_size = 0;
+    }
+
+    persist->hash = checksum_words(
+        persist->hash,
+        dynarr->items + persist->hashed_size,
+        (words_size - persist->hashed_size) / sizeof(uint64_t)
+    );
+    persist->hashed_size = words_size;
+
+    DynArrFileHeader header = {
+        .magic = DYNARR_FILE_MAGIC,
+        .version = DYNARR_FILE_VERSION,
+        .item_size = item_size,
+        .len = len,
+        .checksum = checksum_bytes(persist->hash, dynarr->items + words_size, items_size - words_size)
+    };
+
+    if(write_at(persist->fd, (const char *)&header, sizeof(header), 0) || fdatasync(persist->fd)){
+        return IO_ERR_DYNARR_CODE;
+    }
+
+    persist->published_len = len;
+    dynarr_remove_all(ranges);
+
+    return OK_DYNARR_CODE;
+#else
+    return IO_ERR_DYNARR_CODE;
+#endif
+}
+
+// PUBLIC IMPLEMENTATION DYNARR BATCH
+DynArrBatch *dynarr_batch_create(const DynArrAllocator *allocator, size_t item_size){
+    DynArrBatch *batch = MEMORY_ALLOC(DynArrBatch, 1, allocator);
+
+    if(!batch){
+        return NULL;
+    }
+
+    init_tracked(&batch->edits, sizeof(BatchEdit), allocator);
+    init_tracked(&batch->items, item_size, allocator);
+
+    return batch;
+}
+
+void dynarr_batch_destroy(DynArrBatch *batch){
+    if(!batch){
+        return;
+    }
+
+    const DynArrAllocator *allocator = batch->items.allocator;
+
+    dynarr_deinit(&batch->edits);
+    dynarr_deinit(&batch->items);
+    MEMORY_DEALLOC(batch, DynArrBatch, 1, allocator);
+}
+
+inline size_t dynarr_batch_len(const DynArrBatch *batch){
+    return dynarr_len(&batch->edits);
+}
+
+int dynarr_batch_insert_at(DynArrBatch *batch, size_t idx, const void *item){
+    BatchEdit edit = {.idx = idx, .item = dynarr_len(&batch->items)};
+
+    if(dynarr_insert(&batch->items, item)){
+        return ALLOC_ERR_DYNARR_CODE;
+    }
+
+    if(dynarr_insert(&batch->edits, &edit)){
+        batch->items.used--;
+        return ALLOC_ERR_DYNARR_CODE;
+    }
+
+    return OK_DYNARR_CODE;
+}
+
+int dynarr_batch_remove_index(DynArrBatch *batch, size_t idx){
+    BatchEdit edit = {.idx = idx, .item = SIZE_MAX};
+
+    return dynarr_insert(&batch->edits, &edit);
+}
+
+inline void dynarr_batch_clear(DynArrBatch *batch){
+    dynarr_remove_all(&batch->edits);
+    dynarr_remove_all(&batch->items);
+}
+
+int dynarr_batch_apply(DynArr *dynarr, DynArrBatch *batch){
+    if(dynarr->item_size != batch->items.item_size){
+        return SIZE_MISMATCH_ERR_DYNARR_CODE;
+    }
+
+    size_t edits_len = dynarr_len(&batch->edits);
+
+    if(edits_len == 0){
+        return OK_DYNARR_CODE;
+    }
+
+    size_t old_len = dynarr_len(dynarr);
+    size_t new_len = old_len;
+    size_t root = NO_BATCH_NODE;
+    DynArr nodes;
+    DynArr segments;
+    int code = OK_DYNARR_CODE;
+
+    // replay the edits over a treap of segments first, so an invalid
+    // edit leaves 'dynarr' untouched. Every edit takes at most two nodes
+    DYNARR_INIT_TYPE(&nodes, BatchNode, dynarr->allocator);
+    DYNARR_INIT_TYPE(&segments, BatchSegment, dynarr->allocator);
+
+    if(dynarr_reserve(&nodes, 1 + edits_len * 2)){
+        code = ALLOC_ERR_DYNARR_CODE;
+    }
+
+    if(!code && old_len > 0){
+        root = nodes.used++;
+
+        *(BatchNode *)get_slot(&nodes, root) = (BatchNode){
+            .segment = {.from = 0, .to = old_len, .inserted = 0},
+            .weight = old_len,
+            .left = NO_BATCH_NODE,
+            .right = NO_BATCH_NODE
+        };
+    }
+
+    for (size_t i = 0; i < edits_len && !code; i++){
+        code = replay_edit(&nodes, &root, &new_len, get_slot(&batch->edits, i));
+    }
+
+    if(!code && dynarr_reserve(&segments, dynarr_len(&nodes) > 0 ? dynarr_len(&nodes) : 1)){
+        code = ALLOC_ERR_DYNARR_CODE;
+    }
+
+    if(!code){
+        flatten_segments(get_slot(&nodes, 0), root, &segments);
+    }
+
+    dynarr_deinit(&nodes);
+
+    // the leading run of untouched items needs no write at all
+    size_t first_changed = 0;
+
+    if(!code && dynarr_len(&segments) > 0){
+        BatchSegment *first = get_slot(&segments, 0);
+
+        first_changed = !first->inserted && first->from == 0 ? first->to : 0;
+    }
+
+    if(!code && prepare_write(dynarr, first_changed, new_len > old_len ? new_len : old_len)){
+        code = ALLOC_ERR_DYNARR_CODE;
+    }
+
+    if(!code && new_len > dynarr->capacity && grow_by(dynarr, new_len)){
+        code = ALLOC_ERR_DYNARR_CODE;
+    }
+
+    if(code){
+        dynarr_deinit(&segments);
+        return code;
+    }
+
+    move_segments(dynarr, &segments, new_len, 1);
+    move_segments(dynarr, &segments, new_len, 0);
+
+    size_t out_idx = 0;
+
+    for (size_t i = 0; i < dynarr_len(&segments); i++){
+        BatchSegment *segment = get_slot(&segments, i);
+
+        if(segment->inserted){
+            memcpy(
+                get_slot(dynarr, out_idx),
+                get_slot(&batch->items, segment->from),
+                dynarr->item_size
+            );
+        }
+
+        out_idx += segment->to - segment->from;
+    }
+
+    dynarr->used = new_len;
+    dynarr_deinit(&segments);
+
+    return OK_DYNARR_CODE;
+}
+
+// PUBLIC IMPLEMENTATION DYNARR VIEW
+int dynarr_view(const DynArr *dynarr, size_t from, size_t to, DynArrView *out_view){
+    if(from > to || to > dynarr_len(dynarr)){
+        return IDX_OUT_OF_BOUNDS_ERR_DYNARR_CODE;
+    }
+
+    out_view->items = dynarr->items ? get_slot(dynarr, from) : NULL;
+    out_view->len = to - from;
+    out_view->item_size = dynarr->item_size;
+
+    return OK_DYNARR_CODE;
+}
+
+int dynarr_view_slice(const DynArrView *view, size_t from, size_t to, DynArrView *out_view){
+    if(from > to || to > view->len){
+        return IDX_OUT_OF_BOUNDS_ERR_DYNARR_CODE;
+    }
+
+    out_view->items = view->items ? view->items + from * view->item_size : NULL;
+    out_view->len = to - from;
+    out_view->item_size = view->item_size;
+
+    return OK_DYNARR_CODE;
+}
+
+inline size_t dynarr_view_len(const DynArrView *view){
+    return view->len;
+}
+
+inline const void *dynarr_view_get_raw(const DynArrView *view, size_t idx){
+    if(idx >= view->len){
+        return NULL;
+    }
+
+    return view->items + idx * view->item_size;
+}
+
+// PUBLIC IMPLEMENTATION DYNARR COLS
+DynArrCols *dynarr_cols_create(
+    const DynArrAllocator *allocator,
+    size_t col_count,
+    const size_t *col_item_sizes
+){
+    DynArrCols *cols = MEMORY_ALLOC(DynArrCols, 1, allocator);
+    DynArr *columns = MEMORY_ALLOC(DynArr, col_count, allocator);
+
+    if(!cols || !columns){
+        MEMORY_DEALLOC(cols, DynArrCols, 1, allocator);
+        MEMORY_DEALLOC(columns, DynArr, col_count, allocator);
+
+        return NULL;
+    }
+
+    for (size_t i = 0; i < col_count; i++){
+        init_tracked(&columns[i], col_item_sizes[i], allocator);
+    }
+
+    cols->len = 0;
+    cols->col_count = col_count;
+    cols->columns = columns;
+    cols->allocator = allocator;
+
+    return cols;
+}
+
+void dynarr_cols_destroy(DynArrCols *cols){
+    if(!cols){
+        return;
+    }
+
+    const DynArrAllocator *allocator = cols->allocator;
+
+    for (size_t i = 0; i < cols->col_count; i++){
+        dynarr_deinit(&cols->columns[i]);
+    }
+
+    MEMORY_DEALLOC(cols->columns, DynArr, cols->col_count, allocator);
+    MEMORY_DEALLOC(cols, DynArrCols, 1, allocator);
+}
+
+inline size_t dynarr_cols_len(const DynArrCols *cols){
+    return cols->len;
+}
+
+inline size_t dynarr_cols_count(const DynArrCols *cols){
+    return cols->col_count;
+}
+
+inline const DynArr *dynarr_cols_column(const DynArrCols *cols, size_t col){
+    if(col >= cols->col_count){
+        return NULL;
+    }
+
+    return &cols->columns[col];
+}
+
+inline void *dynarr_cols_get_raw(const DynArrCols *cols, size_t col, size_t idx){
+    if(col >= cols->col_count){
+        return NULL;
+    }
+
+    return dynarr_get_raw(&cols->columns[col], idx);
+}
+
+inline int dynarr_cols_set_at(DynArrCols *cols, size_t col, size_t idx, const void *item){
+    if(col >= cols->col_count){
+        return IDX_OUT_OF_BOUNDS_ERR_DYNARR_CODE;
+    }
+
+    return dynarr_set_at(&cols->columns[col], idx, item);
+}
+
+int dynarr_cols_insert(DynArrCols *cols, const void *const *fields){
+    return dynarr_cols_insert_at(cols, cols->len, fields);
+}
+
+int dynarr_cols_insert_at(DynArrCols *cols, size_t idx, const void *const *fields){
+    if(idx > cols->len){
+        return IDX_OUT_OF_BOUNDS_ERR_DYNARR_CODE;
+    }
+
+    for (size_t i = 0; i < cols->col_count; i++){
+        int code = dynarr_insert_at(&cols->columns[i], idx, fields[i]);
+
+        if(code){
+            // keep columns in sync undoing what was already inserted
+            while (i-- > 0){
+                dynarr_remove_index(&cols->columns[i], idx);
+            }
+
+            return code;
+        }
+    }
+
+    cols->len++;
+
+    return OK_DYNARR_CODE;
+}
+
+int dynarr_cols_remove_index(DynArrCols *cols, size_t idx){
+    if(idx >= cols->len){
+        return IDX_OUT_OF_BOUNDS_ERR_DYNARR_CODE;
+    }
+
+    for (size_t i = 0; i < cols->col_count; i++){
+        dynarr_remove_index(&cols->columns[i], idx);
+    }
+
+    cols->len--;
+
+    return OK_DYNARR_CODE;
+}
+
+int dynarr_cols_remove_if(
+    DynArrCols *cols,
+    size_t col,
+    DynArrPredicate predicate,
+    void *ctx
+){
+    if(col >= cols->col_count){
+        return 0;
+    }
+
+    DynArr *key_column = &cols->columns[col];
+    size_t len = cols->len;
+    size_t keep_count = 0;
+
+    // compact every column in a single pass
+    for (size_t i = 0; i < len; i++){
+        if(predicate(get_slot(key_column, i), ctx)){
+            continue;
+        }
+
+        if(keep_count != i){
+            for (size_t c = 0; c < cols->col_count; c++){
+                DynArr *column = &cols->columns[c];
+
+                memcpy(get_slot(column, keep_count), get_slot(column, i), column->item_size);
+            }
+        }
+
+        keep_count++;
+    }
+
+    for (size_t c = 0; c < cols->col_count; c++){
+        cols->columns[c].used = keep_count;
+    }
+
+    cols->len = keep_count;
+
+    return (int)(len - keep_count);
+}
+
+void dynarr_cols_remove_all(DynArrCols *cols){
+    for (size_t i = 0; i < cols->col_count; i++){
+        dynarr_remove_all(&cols->columns[i]);
+    }
+
+    cols->len = 0;
+}
+
+int dynarr_cols_sort(DynArrCols *cols, size_t key_col, DynArrComparator comparator){
+    if(key_col >= cols->col_count){
+        return IDX_OUT_OF_BOUNDS_ERR_DYNARR_CODE;
+    }
+
+    size_t len = cols->len;
+    size_t max_item_size = 0;
+    DynArr *indexes = NULL;
+
+    if(len < 2){
+        return OK_DYNARR_CODE;
+    }
+
+    for (size_t i = 0; i < cols->col_count; i++){
+        if(cols->columns[i].item_size > max_item_size){
+            max_item_size = cols->columns[i].item_size;
+        }
+    }
+
+    char *temp = MEMORY_ALLOC(char, max_item_size * len, cols->allocator);
+
+    if(!temp || dynarr_argsort(cols->allocator, &cols->columns[key_col], comparator, &indexes)){
+        MEMORY_DEALLOC(temp, char, max_item_size * len, cols->allocator);
+
+        return ALLOC_ERR_DYNARR_CODE;
+    }
+
+    const size_t *raw_indexes = (const size_t *)indexes->items;
+
+    // gather every column through the permutation of the key column
+    for (size_t c = 0; c < cols->col_count; c++){
+        DynArr *column = &cols->columns[c];
+        size_t item_size = column->item_size;
+
+        for (size_t i = 0; i < len; i++){
+            memcpy(temp + i * item_size, get_slot(column, raw_indexes[i]), item_size);
+        }
+
+        memcpy(column->items, temp, item_size * len);
+    }
+
+    dynarr_destroy(indexes);
+    MEMORY_DEALLOC(temp, char, max_item_size * len, cols->allocator);
+
+    return OK_DYNARR_CODE;
+}
+
+// PUBLIC IMPLEMENTATION DYNARR BITS
+DynArrBits *dynarr_bits_create(const DynArrAllocator *allocator){
+    DynArrBits *bits = MEMORY_ALLOC(DynArrBits, 1, allocator);
+
+    if(!bits){
+        return NULL;
+    }
+
+    bits->len = 0;
+    init_tracked(&bits->words, sizeof(uint64_t), allocator);
+
+    return bits;
+}
+
+void dynarr_bits_destroy(DynArrBits *bits){
+    if(!bits){
+        return;
+    }
+
+    const DynArrAllocator *allocator = bits->words.allocator;
+
+    dynarr_deinit(&bits->words);
+    MEMORY_DEALLOC(bits, DynArrBits, 1, allocator);
+}
+
+inline size_t dynarr_bits_len(const DynArrBits *bits){
+    return bits->len;
+}
+
+inline int dynarr_bits_get(const DynArrBits *bits, size_t idx){
+    if(idx >= bits->len){
+        return -1;
+    }
+
+    return (int)((bits_words(bits)[BITS_WORD_IDX(idx)] >> BITS_BIT_IDX(idx)) & 1);
+}
+
+inline int dynarr_bits_set(DynArrBits *bits, size_t idx, int value){
+    if(idx >= bits->len){
+        return IDX_OUT_OF_BOUNDS_ERR_DYNARR_CODE;
+    }
+
+    uint64_t *word = &bits_words(bits)[BITS_WORD_IDX(idx)];
+    uint64_t mask = UINT64_C(1) << BITS_BIT_IDX(idx);
+
+    *word = value ? *word | mask : *word & ~mask;
+
+    return OK_DYNARR_CODE;
+}
+
+inline int dynarr_bits_push(DynArrBits *bits, int value){
+    return dynarr_bits_insert_at(bits, bits->len, value);
+}
+
+int dynarr_bits_insert_at(DynArrBits *bits, size_t idx, int value){
+    size_t len = bits->len;
+
+    if(idx > len){
+        return IDX_OUT_OF_BOUNDS_ERR_DYNARR_CODE;
+    }
+
+    if(BITS_BIT_IDX(len) == 0 && DYNARR_INSERT(&bits->words, uint64_t, 0)){
+        return ALLOC_ERR_DYNARR_CODE;
+    }
+
+    uint64_t *words = bits_words(bits);
+    size_t first_word = BITS_WORD_IDX(idx);
+    size_t last_word = BITS_WORD_IDX(len);
+
+    // carry the top bit of every word into the next one
+    for (size_t i = last_word; i > first_word; i--){
+        words[i] = (words[i] << 1) | (words[i - 1] >> (BITS_WORD_BITS - 1));
+    }
+
+    uint64_t word = words[first_word];
+    uint64_t low_mask = (UINT64_C(1) << BITS_BIT_IDX(idx)) - 1;
+    uint64_t bit = (uint64_t)(value != 0) << BITS_BIT_IDX(idx);
+
+    words[first_word] = (word & low_mask) | ((word & ~low_mask) << 1) | bit;
+    bits->len++;
+
+    return OK_DYNARR_CODE;
+}
+
+int dynarr_bits_remove_index(DynArrBits *bits, size_t idx){
+    size_t len = bits->len;
+
+    if(idx >= len){
+        return IDX_OUT_OF_BOUNDS_ERR_DYNARR_CODE;
+    }
+
+    uint64_t *words = bits_words(bits);
+    size_t first_word = BITS_WORD_IDX(idx);
+    size_t last_word = BITS_WORD_IDX(len - 1);
+    uint64_t word = words[first_word];
+    uint64_t low_mask = (UINT64_C(1) << BITS_BIT_IDX(idx)) - 1;
+
+    words[first_word] = (word & low_mask) | ((word >> 1) & ~low_mask);
+
+    for (size_t i = first_word; i < last_word; i++){
+        words[i] |= words[i + 1] << (BITS_WORD_BITS - 1);
+        words[i + 1] >>= 1;
+    }
+
+    bits->len--;
+
+    if(BITS_WORD_COUNT(bits->len) < dynarr_len(&bits->words)){
+        dynarr_remove_index(&bits->words, last_word);
+    }
+
+    return OK_DYNARR_CODE;
+}
+
+inline void dynarr_bits_remove_all(DynArrBits *bits){
+    bits->len = 0;
+    dynarr_remove_all(&bits->words);
+}
+
+size_t dynarr_bits_popcount(const DynArrBits *bits){
+    const uint64_t *words = bits_words(bits);
+    size_t word_count = BITS_WORD_COUNT(bits->len);
+    size_t counts[4] = {0};
+    size_t i = 0;
+
+    // independent accumulators let popcnt instructions overlap
+    for (; i + 4 <= word_count; i += 4){
+        counts[0] += popcount_word(words[i]);
+        counts[1] += popcount_word(words[i + 1]);
+        counts[2] += popcount_word(words[i + 2]);
+        counts[3] += popcount_word(words[i + 3]);
+    }
+
+    for (; i < word_count; i++){
+        counts[0] += popcount_word(words[i]);
+    }
+
+    return counts[0] + counts[1] + counts[2] + counts[3];
+}
+
+inline int dynarr_bits_find_first_set(const DynArrBits *bits, size_t from, size_t *out_idx){
+    return bits_find_first(bits, from, 0, out_idx);
+}
+
+inline int dynarr_bits_find_first_clear(const DynArrBits *bits, size_t from, size_t *out_idx){
+    return bits_find_first(bits, from, ~UINT64_C(0), out_idx);
+}
+
+int dynarr_bits_and(DynArrBits *to, const DynArrBits *from){
+    return bits_bulk_op(to, from, AND_BITS_OP);
+}
+
+int dynarr_bits_or(DynArrBits *to, const DynArrBits *from){
+    return bits_bulk_op(to, from, OR_BITS_OP);
+}
+
+int dynarr_bits_xor(DynArrBits *to, const DynArrBits *from){
+    return bits_bulk_op(to, from, XOR_BITS_OP);
+}
+
+void dynarr_bits_not(DynArrBits *bits){
+    uint64_t *words = bits_words(bits);
+    size_t word_count = BITS_WORD_COUNT(bits->len);
+
+    for (size_t i = 0; i < word_count; i++){
+        words[i] = ~words[i];
+    }
+
+    bits_clear_tail(bits);
+}
+
+// PUBLIC IMPLEMENTATION DYNARR POOL
+DynArrPool *dynarr_pool_create(const DynArrAllocator *allocator, size_t thread_count){
+    DynArrPool *pool = MEMORY_ALLOC(DynArrPool, 1, allocator);
+
+    if(!pool){
+        return NULL;
+    }
+
+    pool->thread_count = 0;
+    pool->allocator = allocator;
+
+#ifdef DYNARR_POSIX
+    pool->threads_capacity = thread_count;
+    pool->threads = MEMORY_ALLOC(pthread_t, thread_count, allocator);
+    pool->generation = 0;
+    pool->pending = 0;
+    pool->stop = 0;
+    pool->job = NULL;
+
+    if(!pool->threads){
+        MEMORY_DEALLOC(pool, DynArrPool, 1, allocator);
+        return NULL;
+    }
+
+    pthread_mutex_init(&pool->mutex, NULL);
+    pthread_cond_init(&pool->work_cond, NULL);
+    pthread_cond_init(&pool->done_cond, NULL);
+
+    // if some thread can not be started, work with the ones that did
+    for (size_t i = 0; i < thread_count; i++){
+        if(pthread_create(&pool->threads[i], NULL, pool_worker, pool)){
+            break;
+        }
+
+        pool->thread_count++;
+    }
+#else
+    (void)thread_count;
+#endif
+
+    return pool;
+}
+
+void dynarr_pool_destroy(DynArrPool *pool){
+    if(!pool){
+        return;
+    }
+
+#ifdef DYNARR_POSIX
+    pthread_mutex_lock(&pool->mutex);
+    pool->stop = 1;
+    pthread_cond_broadcast(&pool->work_cond);
+    pthread_mutex_unlock(&pool->mutex);
+
+    for (size_t i = 0; i < pool->thread_count; i++){
+        pthread_join(pool->threads[i], NULL);
+    }
+
+    pthread_mutex_destroy(&pool->mutex);
+    pthread_cond_destroy(&pool->work_cond);
+    pthread_cond_destroy(&pool->done_cond);
+    MEMORY_DEALLOC(pool->threads, pthread_t, pool->threads_capacity, pool->allocator);
+#endif
+
+    MEMORY_DEALLOC(pool, DynArrPool, 1, pool->allocator);
+}
+
+int dynarr_parallel_for_each(
+    DynArrPool *pool,
+    DynArr *dynarr,
+    DynArrForEach for_each,
+    void *ctx
+){
+    size_t len = dynarr_len(dynarr);
+
+    if(prepare_write(dynarr, 0, len)){
+        return ALLOC_ERR_DYNARR_CODE;
+    }
+
+    ParallelJob job = {
+        .runner = for_each_chunk,
+        .dynarr = dynarr,
+        .for_each = for_each,
+        .ctx = ctx
+    };
+
+    split_chunks(&job, dynarr, len);
+    pool_run(pool, &job);
+
+    return OK_DYNARR_CODE;
+}
+
+int dynarr_parallel_map(
+    DynArrPool *pool,
+    const DynArr *from,
+    DynArr *to,
+    DynArrMapper mapper,
+    void *ctx
+){
+    size_t len = dynarr_len(from);
+
+    if(prepare_write(to, 0, len)){
+        return ALLOC_ERR_DYNARR_CODE;
+    }
+
+    if(to->capacity < len && grow_by(to, len)){
+        return ALLOC_ERR_DYNARR_CODE;
+    }
+
+    ParallelJob job = {
+        .runner = map_chunk,
+        .dynarr = (DynArr *)from,
+        .out = to,
+        .mapper = mapper,
+        .ctx = ctx
+    };
+
+    // chunks follow the output, which is the one being written
+    split_chunks(&job, to, len);
+    pool_run(pool, &job);
+
+    to->used = len;
+
+    return OK_DYNARR_CODE;
+}
+
+int dynarr_parallel_reduce(
+    DynArrPool *pool,
+    const DynArr *dynarr,
+    const void *identity,
+    DynArrCombiner combiner,
+    void *ctx,
+    void *out_result
+){
+    size_t len = dynarr_len(dynarr);
+    size_t item_size = dynarr->item_size;
+    ParallelJob job = {
+        .runner = reduce_chunk,
+        .dynarr = (DynArr *)dynarr,
+        .combiner = combiner,
+        .identity = identity,
+        .ctx = ctx
+    };
+
+    // no chunks, and no zero sized partials to ask the allocator for
+    if(len == 0){
+        memcpy(out_result, identity, item_size);
+        return OK_DYNARR_CODE;
+    }
+
+    split_chunks(&job, dynarr, len);
+
+    size_t chunk_count = job.chunk_count;
+    char *partials = MEMORY_ALLOC(char, item_size * chunk_count, dynarr->allocator);
+
+    if(!partials){
+        return ALLOC_ERR_DYNARR_CODE;
+    }
+
+    job.partials = partials;
+
+    pool_run(pool, &job);
+
+    // partials are combined in order, so 'combiner' only has to be
+    // associative
+    memcpy(out_result, identity, item_size);
+
+    for (size_t i = 0; i < chunk_count; i++){
+        combiner(out_result, partials + i * item_size, ctx);
+    }
+
+    MEMORY_DEALLOC(partials, char, item_size * chunk_count, dynarr->allocator);
+
+    return OK_DYNARR_CODE;
+}
+
+int dynarr_parallel_prefix_scan(
+    DynArrPool *pool,
+    DynArr *dynarr,
+    const void *identity,
+    DynArrCombiner combiner,
+    void *ctx
+){
+    size_t len = dynarr_len(dynarr);
+    size_t item_size = dynarr->item_size;
+
+    if(len == 0){
+        return OK_DYNARR_CODE;
+    }
+
+    if(prepare_write(dynarr, 0, len)){
+        return ALLOC_ERR_DYNARR_CODE;
+    }
+
+    ParallelJob job = {
+        .runner = reduce_chunk,
+        .dynarr = dynarr,
+        .combiner = combiner,
+        .identity = identity,
+        .ctx = ctx
+    };
+
+    split_chunks(&job, dynarr, len);
+
+    size_t chunk_count = job.chunk_count;
+    char *partials = MEMORY_ALLOC(char, item_size * chunk_count, dynarr->allocator);
+
+    if(!partials){
+        return ALLOC_ERR_DYNARR_CODE;
+    }
+
+    job.partials = partials;
+
+    // first pass totals every chunk, then those totals become the
+    // exclusive prefix each chunk starts its own scan from
+    pool_run(pool, &job);
+
+    char running[item_size];
+    char total[item_size];
+
+    memcpy(running, identity, item_size);
+
+    for (size_t i = 0; i < chunk_count; i++){
+        char *partial = partials + i * item_size;
+
+        memcpy(total, partial, item_size);
+        memcpy(partial, running, item_size);
+        combiner(running, total, ctx);
+    }
+
+    job.runner = scan_chunk;
+    pool_run(pool, &job);
+
+    MEMORY_DEALLOC(partials, char, item_size * chunk_count, dynarr->allocator);
+
+    return OK_DYNARR_CODE;
+}
+
+// PUBLIC IMPLEMENTATION DYNARR PACKED
+int dynarr_packed_create(
+    const DynArrAllocator *allocator,
+    const DynArr *sorted,
+    DynArrPacked **out_packed
+){
+    size_t item_size = sorted->item_size;
+
+    if(item_size != sizeof(uint32_t) && item_size != sizeof(uint64_t)){
+        return INCORRECT_SIZE_ERR_DYNARR_CODE;
+    }
+
+    size_t len = dynarr_len(sorted);
+
+    for (size_t i = 1; i < len; i++){
+        if(read_uint(sorted, i) < read_uint(sorted, i - 1)){
+            return NOT_SORTED_ERR_DYNARR_CODE;
+        }
+    }
+
+    DynArrPacked *packed = MEMORY_ALLOC(DynArrPacked, 1, allocator);
+
+    if(!packed){
+        return ALLOC_ERR_DYNARR_CODE;
+    }
+
+    packed->len = len;
+    packed->item_size = item_size;
+    init_tracked(&packed->blocks, sizeof(PackedBlock), allocator);
+    init_tracked(&packed->words, sizeof(uint64_t), allocator);
+
+    uint64_t deltas[PACKED_BLOCK_LEN];
+
+    for (size_t from = 0; from < len; from += PACKED_BLOCK_LEN){
+        size_t to = from + PACKED_BLOCK_LEN < len ? from + PACKED_BLOCK_LEN : len;
+        size_t delta_count = to - from - 1;
+        uint64_t max_delta = 0;
+
+        for (size_t i = 0; i < delta_count; i++){
+            deltas[i] = read_uint(sorted, from + i + 1) - read_uint(sorted, from + i);
+            max_delta |= deltas[i];
+        }
+
+        PackedBlock block = {
+            .first = read_uint(sorted, from),
+            .word_offset = dynarr_len(&packed->words),
+            .width = bit_width(max_delta)
+        };
+        size_t word_count = (delta_count * block.width + 63) / 64;
+        int failed = dynarr_insert(&packed->blocks, &block) != OK_DYNARR_CODE;
+
+        for (size_t i = 0; i < word_count && !failed; i++){
+            failed = DYNARR_INSERT(&packed->words, uint64_t, 0) != OK_DYNARR_CODE;
+        }
+
+        if(failed){
+            dynarr_packed_destroy(packed);
+            return ALLOC_ERR_DYNARR_CODE;
+        }
+
+        if(word_count > 0){
+            pack_bits(
+                (uint64_t *)packed->words.items + block.word_offset,
+                delta_count,
+                block.width,
+                deltas
+            );
+        }
+    }
+
+    *out_packed = packed;
+
+    return OK_DYNARR_CODE;
+}
+
+void dynarr_packed_destroy(DynArrPacked *packed){
+    if(!packed){
+        return;
+    }
+
+    const DynArrAllocator *allocator = packed->words.allocator;
+
+    dynarr_deinit(&packed->blocks);
+    dynarr_deinit(&packed->words);
+    MEMORY_DEALLOC(packed, DynArrPacked, 1, allocator);
 }
 
-inline void *dynarr_get_ptr(const DynArr *dynarr, size_t idx){
-    if(idx >= dynarr_len(dynarr)){
-        return NULL;
+inline size_t dynarr_packed_len(const DynArrPacked *packed){
+    return packed->len;
+}
+
+size_t dynarr_packed_size(const DynArrPacked *packed){
+    return sizeof(DynArrPacked) +
+           dynarr_len(&packed->blocks) * sizeof(PackedBlock) +
+           dynarr_len(&packed->words) * sizeof(uint64_t);
+}
+
+size_t dynarr_packed_lower_bound(const DynArrPacked *packed, uint64_t value){
+    return packed_search(packed, value, NULL);
+}
+
+int dynarr_packed_find(const DynArrPacked *packed, uint64_t value, size_t *out_idx){
+    uint64_t found;
+    size_t idx = packed_search(packed, value, &found);
+
+    if(idx >= packed->len || found != value){
+        return 0;
     }
 
-    return (void *)(*(uintptr_t *)get_slot(dynarr, idx));
+    *out_idx = idx;
+
+    return 1;
 }
 
-inline int dynarr_set_at(DynArr *dynarr, size_t idx, const void *item){
-    if(idx >= dynarr_len(dynarr)){
-        return IDX_OUT_OF_BOUNDS_ERR_DYNARR_CODE;
+int dynarr_packed_decode(const DynArrPacked *packed, DynArr *out){
+    if(out->item_size != packed->item_size){
+        return SIZE_MISMATCH_ERR_DYNARR_CODE;
     }
 
-    memmove(get_slot(dynarr, idx), item, dynarr->item_size);
+    size_t out_len = dynarr_len(out);
+    size_t len = packed->len;
+
+    if(prepare_write(out, out_len, out_len + len)){
+        return ALLOC_ERR_DYNARR_CODE;
+    }
+
+    if(dynarr_available(out) < len && grow_by(out, out_len + len)){
+        return ALLOC_ERR_DYNARR_CODE;
+    }
+
+    uint64_t values[PACKED_BLOCK_LEN];
+
+    // one block at a time, so the decoded values stay in cache
+    for (size_t block_idx = 0; block_idx < dynarr_len(&packed->blocks); block_idx++){
+        size_t block_len = decode_block(packed, block_idx, values);
+        char *slot = get_slot(out, out->used);
+
+        if(packed->item_size == sizeof(uint32_t)){
+            uint32_t *out_values = (uint32_t *)slot;
+
+            for (size_t i = 0; i < block_len; i++){
+                out_values[i] = (uint32_t)values[i];
+            }
+        }else{
+            memcpy(slot, values, sizeof(uint64_t) * block_len);
+        }
+
+        out->used += block_len;
+    }
 
     return OK_DYNARR_CODE;
 }
 
-inline int dynarr_set_ptr(DynArr *dynarr, size_t idx, const void *ptr){
-    if(idx >= dynarr_len(dynarr)){
-        return IDX_OUT_OF_BOUNDS_ERR_DYNARR_CODE;
+// PUBLIC IMPLEMENTATION DYNARR MEMORY
+void dynarr_set_memory_limit(size_t limit){
+    registry_lock();
+    registry.limit = limit;
+    registry_unlock();
+}
+
+void dynarr_set_memory_pressure(DynArrMemoryPressure on_pressure, void *ctx){
+    registry_lock();
+    registry.on_pressure = on_pressure;
+    registry.pressure_ctx = ctx;
+    registry_unlock();
+}
+
+void dynarr_memory_stats(DynArrMemoryStats *out_stats){
+    DynArrMemoryStats stats = {0};
+
+    registry_lock();
+
+    for (DynArr *dynarr = registry.head; dynarr; dynarr = dynarr->tracked_next){
+        stats.arrays++;
+        stats.used += dynarr->used * dynarr->item_size;
     }
 
-    size_t rsize = dynarr->item_size;
-    uintptr_t iptr = (uintptr_t)ptr;
+    stats.reserved = registry.reserved;
+    stats.limit = registry.limit;
 
-    memmove(get_slot(dynarr, idx), &iptr, rsize);
+    registry_unlock();
 
-    return OK_DYNARR_CODE;
+    *out_stats = stats;
 }
 
-inline int dynarr_insert(DynArr *dynarr, const void *item){
-    if (dynarr->used >= dynarr->capacity && grow(dynarr)){
-        return ALLOC_ERR_DYNARR_CODE;
+size_t dynarr_trim_all(void){
+    registry_lock();
+    size_t reserved = registry.reserved;
+    DynArr *dynarr = registry.head;
+    registry_unlock();
+
+    while (dynarr){
+        // shared and mapped buffers are not owned by one array alone
+        if(!dynarr->share){
+            fit_items(dynarr);
+        }
+
+        registry_lock();
+        dynarr = dynarr->tracked_next;
+        registry_unlock();
     }
 
-    memmove(get_slot(dynarr, dynarr->used++), item, dynarr->item_size);
+    registry_lock();
+    size_t released = reserved > registry.reserved ? reserved - registry.reserved : 0;
+    registry_unlock();
 
-    return OK_DYNARR_CODE;
+    return released;
 }
 
-int dynarr_insert_at(DynArr *dynarr, size_t idx, const void *item){
-    size_t len = dynarr_len(dynarr);
+// PUBLIC IMPLEMENTATION DYNARR VAR
+DynArrVar *dynarr_var_create(const DynArrAllocator *allocator){
+    DynArrVar *var = MEMORY_ALLOC(DynArrVar, 1, allocator);
 
-    if(idx > len){
-        return IDX_OUT_OF_BOUNDS_ERR_DYNARR_CODE;
+    if(!var){
+        return NULL;
     }
 
-    if(dynarr_available(dynarr) == 0 && grow(dynarr)){
-        return ALLOC_ERR_DYNARR_CODE;
+    init_tracked(&var->entries, sizeof(VarEntry), allocator);
+    init_tracked(&var->bytes, sizeof(char), allocator);
+
+    return var;
+}
+
+void dynarr_var_destroy(DynArrVar *var){
+    if(!var){
+        return;
     }
 
-    move_items(dynarr, idx, idx + 1);
-    memmove(get_slot(dynarr, idx), item, dynarr->item_size);
+    const DynArrAllocator *allocator = var->bytes.allocator;
 
-    dynarr->used++;
+    dynarr_deinit(&var->entries);
+    dynarr_deinit(&var->bytes);
+    MEMORY_DEALLOC(var, DynArrVar, 1, allocator);
+}
+
+inline size_t dynarr_var_len(const DynArrVar *var){
+    return dynarr_len(&var->entries);
+}
+
+inline size_t dynarr_var_bytes(const DynArrVar *var){
+    return dynarr_len(&var->bytes);
+}
+
+int dynarr_var_reserve(DynArrVar *var, size_t count, size_t bytes){
+    if(dynarr_reserve(&var->entries, dynarr_len(&var->entries) + count) ||
+       dynarr_reserve(&var->bytes, dynarr_len(&var->bytes) + bytes)){
+        return ALLOC_ERR_DYNARR_CODE;
+    }
 
     return OK_DYNARR_CODE;
 }
 
-inline int dynarr_insert_ptr(DynArr *dynarr, const void *ptr){
-    if(dynarr->item_size != sizeof(uintptr_t)){
-        return INCORRECT_SIZE_ERR_DYNARR_CODE;
+int dynarr_var_push(DynArrVar *var, const void *payload, size_t size){
+    DynArr *bytes = &var->bytes;
+    size_t bytes_len = dynarr_len(bytes);
+
+    // doubling, so pushing n payloads costs O(log n) arena reallocations
+    if(dynarr_available(bytes) < size){
+        size_t capacity = bytes->capacity * 2;
+
+        if(capacity < bytes_len + size){
+            capacity = bytes_len + size;
+        }
+
+        if(capacity < CACHE_LINE_SIZE){
+            capacity = CACHE_LINE_SIZE;
+        }
+
+        if(dynarr_reserve(bytes, capacity)){
+            return ALLOC_ERR_DYNARR_CODE;
+        }
     }
 
-    uintptr_t iptr = (uintptr_t)ptr;
+    VarEntry entry = {.offset = bytes_len, .size = size};
 
-    return dynarr_insert(dynarr, &iptr);
+    if(dynarr_insert(&var->entries, &entry)){
+        return ALLOC_ERR_DYNARR_CODE;
+    }
+
+    if(size > 0){
+        memcpy(get_slot(bytes, bytes_len), payload, size);
+    }
+
+    bytes->used += size;
+
+    return OK_DYNARR_CODE;
 }
 
-inline int dynarr_insert_ptr_at(DynArr *dynarr, size_t idx, const void *ptr){
-    if(dynarr->item_size != sizeof(uintptr_t)){
-        return INCORRECT_SIZE_ERR_DYNARR_CODE;
+const void *dynarr_var_get(const DynArrVar *var, size_t idx, size_t *out_size){
+    if(idx >= dynarr_len(&var->entries)){
+        return NULL;
     }
 
-    uintptr_t iptr = (uintptr_t)ptr;
+    const VarEntry *entry = get_slot(&var->entries, idx);
 
-    return dynarr_insert_at(dynarr, idx, &iptr);
+    if(out_size){
+        *out_size = entry->size;
+    }
+
+    return var_payload(var, entry);
 }
 
-int dynarr_append(DynArr *to, const DynArr *from){
-    size_t from_len = dynarr_len(from);
+int dynarr_var_remove_if(DynArrVar *var, DynArrVarPredicate predicate, void *ctx){
+    size_t len = dynarr_len(&var->entries);
+    size_t kept = 0;
 
-    if(from_len == 0){
-        return DYNARR_EMPTY_ERR_DYNARR_CODE;
+    for (size_t i = 0; i < len; i++){
+        VarEntry *entry = get_slot(&var->entries, i);
+
+        if(predicate(var_payload(var, entry), entry->size, ctx)){
+            continue;
+        }
+
+        *(VarEntry *)get_slot(&var->entries, kept++) = *entry;
     }
 
-    size_t to_len = dynarr_len(to);
-    size_t to_available = dynarr_available(to);
-    size_t to_start_idx = to_len;
+    var->entries.used = kept;
 
-    if(from_len <= to_available){
-        memmove(
-            get_slot(to, to_start_idx),
-            get_slot(from, 0),
-            from->item_size * from_len
-        );
+    // without memory for a new arena the holes just stay until next time
+    compact_arena(var);
 
-        to->used += from_len;
+    return (int)(len - kept);
+}
 
+void dynarr_var_remove_all(DynArrVar *var){
+    dynarr_remove_all(&var->entries);
+    dynarr_remove_all(&var->bytes);
+}
+
+int dynarr_var_sort(DynArrVar *var, DynArrVarComparator comparator){
+    size_t len = dynarr_len(&var->entries);
+    const DynArrAllocator *allocator = var->entries.allocator;
+
+    // nothing to sort, and no zero sized scratch to ask the allocator for
+    if(len == 0){
         return OK_DYNARR_CODE;
     }
 
-    if(dynarr_make_room(to, from_len - to_available)){
+    VarEntry *temp = MEMORY_ALLOC(VarEntry, len, allocator);
+
+    if(!temp){
         return ALLOC_ERR_DYNARR_CODE;
     }
 
-    memmove(
-        get_slot(to, to_start_idx),
-        get_slot(from, 0),
-        from->item_size * from_len
+    merge_sort_entries(
+        var,
+        (VarEntry *)var->entries.items,
+        temp,
+        len,
+        comparator
     );
+    MEMORY_DEALLOC(temp, VarEntry, len, allocator);
 
-    to->used += from_len;
+    // payloads back in item order, so scans read the arena sequentially
+    compact_arena(var);
 
     return OK_DYNARR_CODE;
 }
 
-int dynarr_join(
+// PUBLIC IMPLEMENTATION DYNARR PMA
+DynArrPma *dynarr_pma_create(
     const DynArrAllocator *allocator,
-    const DynArr *a_dynarr,
-    const DynArr *b_dynarr,
-    DynArr **out_new_dynarr
+    size_t item_size,
+    DynArrComparator comparator
 ){
-    size_t a_item_size = a_dynarr->item_size;
-    size_t b_item_size = b_dynarr->item_size;
+    DynArrPma *pma = MEMORY_ALLOC(DynArrPma, 1, allocator);
 
-    if(a_item_size != b_item_size){
-        return SIZE_MISMATCH_ERR_DYNARR_CODE;
+    if(!pma){
+        return NULL;
     }
 
-    #define ITEM_SIZE a_item_size
+    pma->len = 0;
+    pma->segment_len = PMA_MIN_CAPACITY;
+    pma->comparator = comparator;
+    init_tracked(&pma->slots, item_size, allocator);
+    init_tracked(&pma->occupied, sizeof(unsigned char), allocator);
 
-    size_t a_len = dynarr_len(a_dynarr);
-    size_t b_len = dynarr_len(b_dynarr);
-    size_t c_len = a_len + b_len;
-    DynArr *c_dynarr = dynarr_create_by(allocator, ITEM_SIZE, c_len);
+    if(pma_resize(pma, PMA_MIN_CAPACITY)){
+        dynarr_pma_destroy(pma);
+        return NULL;
+    }
 
-    if(!c_dynarr){
-        return ALLOC_ERR_DYNARR_CODE;
+    return pma;
+}
+
+void dynarr_pma_destroy(DynArrPma *pma){
+    if(!pma){
+        return;
     }
 
-    memcpy(c_dynarr->items, a_dynarr->items, ITEM_SIZE * a_len);
-    memcpy(get_slot(c_dynarr, a_len), b_dynarr->items, ITEM_SIZE * b_len);
+    const DynArrAllocator *allocator = pma->slots.allocator;
 
-    c_dynarr->used = c_len;
-    *out_new_dynarr = c_dynarr;
+    dynarr_deinit(&pma->slots);
+    dynarr_deinit(&pma->occupied);
+    MEMORY_DEALLOC(pma, DynArrPma, 1, allocator);
+}
+
+inline size_t dynarr_pma_len(const DynArrPma *pma){
+    return pma->len;
+}
+
+inline size_t dynarr_pma_capacity(const DynArrPma *pma){
+    return pma->slots.capacity;
+}
+
+int dynarr_pma_insert(DynArrPma *pma, const void *item){
+    size_t pred;
+
+    pma_search(pma, item, 1, &pred);
+
+    size_t capacity = pma->slots.capacity;
+    size_t window_len = pma->segment_len;
+    size_t start = pred == SIZE_MAX ? 0 : pred / window_len * window_len;
+
+    // smallest window around the insertion point with room to spare
+    while (window_len < capacity){
+        double upper = pma_threshold(pma, window_len, PMA_LEAF_UPPER, PMA_ROOT_UPPER);
+
+        if((double)(pma_count(pma, start, window_len) + 1) <= upper * (double)window_len){
+            break;
+        }
+
+        window_len *= 2;
+        start = start / window_len * window_len;
+    }
+
+    if(window_len == capacity &&
+       (double)(pma->len + 1) > PMA_ROOT_UPPER * (double)capacity){
+        if(pma_resize(pma, capacity * 2)){
+            return ALLOC_ERR_DYNARR_CODE;
+        }
+
+        window_len = pma->slots.capacity;
+        start = 0;
+    }
+
+    // the new item goes right after 'pred' among the packed items
+    size_t at = pred == SIZE_MAX || pred < start ? 0 : pma_count(pma, start, pred + 1 - start);
+    size_t count = pma_compact(pma, start, window_len);
+    char *slot = get_slot(&pma->slots, start + at);
+
+    memmove(slot + pma->slots.item_size, slot, pma->slots.item_size * (count - at));
+    memcpy(slot, item, pma->slots.item_size);
+    ((unsigned char *)pma->occupied.items)[start + count] = 1;
+
+    pma_spread(pma, start, window_len, count + 1);
+    pma->len++;
 
     return OK_DYNARR_CODE;
 }
 
-inline int dynarr_remove_index(DynArr *dynarr, size_t idx){
-    size_t len = dynarr_len(dynarr);
+int dynarr_pma_remove(DynArrPma *pma, const void *item){
+    size_t capacity = pma->slots.capacity;
+    size_t slot = pma_next_occupied(pma, pma_search(pma, item, 0, NULL), capacity);
 
-    if(idx >= len){
+    if(slot == capacity || pma->comparator(get_slot(&pma->slots, slot), item) != 0){
+        return 0;
+    }
+
+    ((unsigned char *)pma->occupied.items)[slot] = 0;
+    pma->len--;
+
+    size_t window_len = pma->segment_len;
+    size_t start = slot / window_len * window_len;
+
+    // smallest window around the hole that is still dense enough
+    while (window_len < capacity){
+        double lower = pma_threshold(pma, window_len, PMA_LEAF_LOWER, PMA_ROOT_LOWER);
+
+        if((double)pma_count(pma, start, window_len) >= lower * (double)window_len){
+            break;
+        }
+
+        window_len *= 2;
+        start = start / window_len * window_len;
+    }
+
+    if(window_len == pma->segment_len){
+        return 1;
+    }
+
+    size_t count = pma_compact(pma, start, window_len);
+
+    if(window_len == capacity &&
+       capacity > PMA_MIN_CAPACITY &&
+       (double)count < PMA_ROOT_LOWER * (double)capacity){
+        // failing to shrink just leaves the array larger
+        pma_resize(pma, capacity / 2);
+        window_len = pma->slots.capacity;
+    }
+
+    if(count > 0){
+        pma_spread(pma, start, window_len, count);
+    }
+
+    return 1;
+}
+
+size_t dynarr_pma_lower_bound(const DynArrPma *pma, const void *item){
+    return pma_search(pma, item, 0, NULL);
+}
+
+const void *dynarr_pma_find(const DynArrPma *pma, const void *item){
+    size_t capacity = pma->slots.capacity;
+    size_t slot = pma_next_occupied(pma, pma_search(pma, item, 0, NULL), capacity);
+
+    if(slot == capacity || pma->comparator(get_slot(&pma->slots, slot), item) != 0){
+        return NULL;
+    }
+
+    return get_slot(&pma->slots, slot);
+}
+
+const void *dynarr_pma_next(const DynArrPma *pma, size_t *cursor){
+    size_t capacity = pma->slots.capacity;
+    size_t slot = pma_next_occupied(pma, *cursor, capacity);
+
+    if(slot == capacity){
+        *cursor = capacity;
+        return NULL;
+    }
+
+    *cursor = slot + 1;
+
+    return get_slot(&pma->slots, slot);
+}
+
+// PUBLIC IMPLEMENTATION DYNARR CURSOR
+int dynarr_cursor(DynArr *dynarr, size_t from, size_t to, DynArrCursor *out_cursor){
+    if(from > to || to > dynarr_len(dynarr)){
         return IDX_OUT_OF_BOUNDS_ERR_DYNARR_CODE;
     }
 
-    if(idx < len - 1){
-        move_items(dynarr, idx + 1, idx);
+    // spans are writable, so the range is taken as written
+    if(prepare_write(dynarr, from, to)){
+        return ALLOC_ERR_DYNARR_CODE;
     }
 
-    dynarr->used--;
+    out_cursor->dynarr = dynarr;
+    out_cursor->idx = from;
+    out_cursor->to = to;
 
     return OK_DYNARR_CODE;
 }
 
-int dynarr_remove_if(DynArr *dynarr, DynArrPredicate predicate, void *ctx){
-    size_t i = 0;
-    size_t remove_count  = 0;
+int dynarr_cursor_next(DynArrCursor *cursor, size_t max_count, DynArrSpan *out_span){
+    size_t remaining = cursor->to - cursor->idx;
+    size_t count = max_count > 0 && max_count < remaining ? max_count : remaining;
 
-    while (i < dynarr_len(dynarr)){
-        void *item = dynarr_get_raw(dynarr, i);
+    if(count == 0){
+        return 0;
+    }
 
-        if(predicate(item, ctx)){
-            dynarr_remove_index(dynarr, i);
+    DynArr *dynarr = cursor->dynarr;
 
-            remove_count++;
-        }else{
-            i++;
-        }
+    // the items are one flat buffer, so a span can cover all that is left
+    out_span->items = get_slot(dynarr, cursor->idx);
+    out_span->count = count;
+    out_span->stride = dynarr->item_size;
+    out_span->item_size = dynarr->item_size;
+
+    cursor->idx += count;
+
+    return 1;
+}
+
+int dynarr_const_cursor(const DynArr *dynarr, size_t from, size_t to, DynArrConstCursor *out_cursor){
+    if(from > to || to > dynarr_len(dynarr)){
+        return IDX_OUT_OF_BOUNDS_ERR_DYNARR_CODE;
     }
 
-    return remove_count;
+    out_cursor->dynarr = dynarr;
+    out_cursor->idx = from;
+    out_cursor->to = to;
+
+    return OK_DYNARR_CODE;
 }
 
-inline void dynarr_remove_all(DynArr *dynarr){
-    dynarr->used = 0;
+int dynarr_const_cursor_next(DynArrConstCursor *cursor, size_t max_count, DynArrConstSpan *out_span){
+    size_t remaining = cursor->to - cursor->idx;
+    size_t count = max_count > 0 && max_count < remaining ? max_count : remaining;
+
+    if(count == 0){
+        return 0;
+    }
+
+    const DynArr *dynarr = cursor->dynarr;
+
+    out_span->items = get_slot(dynarr, cursor->idx);
+    out_span->count = count;
+    out_span->stride = dynarr->item_size;
+    out_span->item_size = dynarr->item_size;
+
+    cursor->idx += count;
+
+    return 1;
+}
+
+int dynarr_for_each_batch(const DynArr *dynarr, DynArrBlockFn block_fn, void *ctx){
+    size_t item_size = dynarr->item_size;
+    size_t block_items = DYNARR_BLOCK_BYTES / item_size > 0 ? DYNARR_BLOCK_BYTES / item_size : 1;
+    DynArrConstCursor cursor;
+    DynArrConstSpan span;
+
+    int code = dynarr_const_cursor(dynarr, 0, dynarr_len(dynarr), &cursor);
+
+    if(code){
+        return code;
+    }
+
+    while (dynarr_const_cursor_next(&cursor, block_items, &span)){
+        size_t first_idx = cursor.idx - span.count;
+        size_t next_count = cursor.to - cursor.idx < block_items ?
+                            cursor.to - cursor.idx :
+                            block_items;
+        const char *next = span.items + span.count * span.stride;
+
+        // the next block is on its way while this one is processed
+        for (size_t offset = 0; offset < next_count * item_size; offset += CACHE_LINE_SIZE){
+            PREFETCH(next + offset);
+        }
+
+        block_fn(&span, first_idx, ctx);
+    }
+
+    return OK_DYNARR_CODE;
 }
\ No newline at end of file
@@ -11,6 +11,8 @@
 #define DYNARR_DEFAULT_GROW_SIZE 8
 #endif
 
+#define DYNARR_PAGE_ALIGNMENT ((size_t)-1)
+
 typedef enum dynarr_code{
     OK_DYNARR_CODE,
     ALLOC_ERR_DYNARR_CODE,
@@ -18,6 +20,9 @@ typedef enum dynarr_code{
     DYNARR_EMPTY_ERR_DYNARR_CODE,
     IDX_OUT_OF_BOUNDS_ERR_DYNARR_CODE,
     INCORRECT_SIZE_ERR_DYNARR_CODE,
+    IO_ERR_DYNARR_CODE,
+    FORMAT_ERR_DYNARR_CODE,
+    NOT_SORTED_ERR_DYNARR_CODE,
 }DynArrCode;
 
 typedef struct dynarr_allocator{
@@ -29,9 +34,88 @@ typedef struct dynarr_allocator{
 
 typedef int (*DynArrComparator)(const void *a, const void *b);
 typedef int (*DynArrPredicate)(const void *item, void *ctx);
+typedef void (*DynArrKeyExtractor)(const void *item, void *out_key);
+typedef void (*DynArrForEach)(void *item, size_t idx, void *ctx);
+typedef void (*DynArrMapper)(const void *item, void *out_item, void *ctx);
+// Folds 'item' into 'acc', both of the array item type
+typedef void (*DynArrCombiner)(void *acc, const void *item, void *ctx);
 typedef struct dynarr DynArr;
+typedef struct dynarr_cols DynArrCols;
+typedef struct dynarr_bits DynArrBits;
+typedef struct dynarr_pool DynArrPool;
+typedef struct dynarr_batch DynArrBatch;
+typedef struct dynarr_packed DynArrPacked;
+typedef struct dynarr_var DynArrVar;
+typedef struct dynarr_pma DynArrPma;
+typedef int (*DynArrVarPredicate)(const void *payload, size_t size, void *ctx);
+typedef int (*DynArrVarComparator)(
+    const void *a,
+    size_t a_size,
+    const void *b,
+    size_t b_size
+);
+// 'excess' bytes over the limit the growth that triggered it needs
+typedef void (*DynArrMemoryPressure)(size_t excess, void *ctx);
+
+typedef struct dynarr_memory_stats{
+    size_t arrays;
+    // bytes of items in use and bytes held by items buffers
+    size_t used;
+    size_t reserved;
+    size_t limit;
+}DynArrMemoryStats;
+
+// Read only window over a range of a DynArr. It lives wherever the
+// caller puts it and allocates nothing, but it is invalidated by
+// anything that reallocates or unshares the viewed DynArr
+typedef struct dynarr_view{
+    const char *items;
+    size_t len;
+    size_t item_size;
+}DynArrView;
+
+// Contiguous run of items, item 'i' at 'items + i * stride'
+typedef struct dynarr_span{
+    char *items;
+    size_t count;
+    size_t stride;
+    size_t item_size;
+}DynArrSpan;
+
+// Read-only DynArrSpan
+typedef struct dynarr_const_span{
+    const char *items;
+    size_t count;
+    size_t stride;
+    size_t item_size;
+}DynArrConstSpan;
+
+// Position in a range of a DynArr, handed out span by span. Like a
+// view, it is invalidated by anything that reallocates the DynArr
+typedef struct dynarr_cursor{
+    DynArr *dynarr;
+    size_t idx;
+    size_t to;
+}DynArrCursor;
+
+// Read-only DynArrCursor
+typedef struct dynarr_const_cursor{
+    const DynArr *dynarr;
+    size_t idx;
+    size_t to;
+}DynArrConstCursor;
+
+typedef void (*DynArrBlockFn)(const DynArrConstSpan *span, size_t first_idx, void *ctx);
 
 // PUBLIC INTERFACE DYNARR
+// dynarr_init works on caller storage, which the library cannot see go
+// away, so such a DynArr is left out of dynarr_memory_stats counts and
+// dynarr_trim_all. Its items buffer still counts toward reserved bytes
+// and the memory limit until dynarr_deinit
+//
+// The storage must be at least dynarr_size() bytes, aligned as malloc
+// would align it
+size_t dynarr_size(void);
 DynArr *dynarr_init(void *dynarr, size_t item_size, const DynArrAllocator *allocator);
 DynArr *dynarr_create(const DynArrAllocator *allocator, size_t item_size);
 DynArr *dynarr_create_by(
@@ -39,6 +123,12 @@ DynArr *dynarr_create_by(
     size_t item_size,
     size_t item_count
 );
+// Capacity of exactly 'item_count' items
+DynArr *dynarr_create_exact(
+    const DynArrAllocator *allocator,
+    size_t item_size,
+    size_t item_count
+);
 
 #define DYNARR_INIT_TYPE(_dynarr, _type, _allocator) \
     (dynarr_init((_dynarr), sizeof(_type), (_allocator)))
@@ -55,6 +145,14 @@ DynArr *dynarr_create_by(
 #define DYNARR_CREATE_PTR_BY(_allocator, _count) \
     DYNARR_CREATE_TYPE_BY((_allocator), uintptr_t, (_count))
 
+#define DYNARR_CREATE_TYPE_EXACT(_allocator, _type, _count) \
+    (dynarr_create_exact((_allocator), sizeof(_type), (_count)))
+
+// Shares the items of 'dynarr' with the clone. Whichever is written first
+// (insert, set, remove, sort...) takes its own copy. Writes made through
+// pointers from dynarr_get_raw are not tracked. Not thread safe
+DynArr *dynarr_clone(DynArr *dynarr);
+
 void dynarr_deinit(DynArr *dynarr);
 void dynarr_destroy(DynArr *dynarr);
 
@@ -62,11 +160,51 @@ size_t dynarr_len(const DynArr *dynarr);
 size_t dynarr_capacity(const DynArr *dynarr);
 size_t dynarr_item_size(const DynArr *dynarr);
 size_t dynarr_available(const DynArr *dynarr);
+// 'alignment' is a power of two or DYNARR_PAGE_ALIGNMENT. Every buffer
+// the array gets from then on (grow, shrink, join result...) honors it
+int dynarr_set_alignment(DynArr *dynarr, size_t alignment);
+size_t dynarr_alignment(const DynArr *dynarr);
+// Asks for transparent huge pages (MADV_HUGEPAGE) once the buffer is
+// larger than DYNARR_HUGE_PAGE_THRESHOLD. Ignored where unsupported
+void dynarr_set_huge_pages(DynArr *dynarr, int enabled);
+// Room for at least 'count' more items, capacity rounded up to
+// multiples of DYNARR_DEFAULT_GROW_SIZE
 int dynarr_make_room(DynArr *dynarr, size_t count);
+// Capacity of exactly 'total' items if it is less, in one allocation
+int dynarr_reserve(DynArr *dynarr, size_t total);
+int dynarr_shrink_to_fit(DynArr *dynarr);
 int dynarr_reduce(DynArr *dynarr);
 
-void dynarr_reverse(DynArr *dyarr);
-void dynarr_sort(DynArr *dynarr, DynArrComparator comparator);
+int dynarr_reverse(DynArr *dyarr);
+int dynarr_sort(DynArr *dynarr, DynArrComparator comparator);
+int dynarr_nth_element(DynArr *dynarr, size_t nth, DynArrComparator comparator);
+int dynarr_partial_sort(DynArr *dynarr, size_t k, DynArrComparator comparator);
+// Keeps in 'dynarr' (as a heap) the 'k' items that would come first after
+// sorting with 'comparator'. Call dynarr_top_k_sort once done pushing
+int dynarr_top_k_push(
+    DynArr *dynarr,
+    size_t k,
+    const void *item,
+    DynArrComparator comparator
+);
+int dynarr_top_k_sort(DynArr *dynarr, DynArrComparator comparator);
+// Creates a DynArr of size_t indexes such that visiting 'dynarr' in that
+// order gives its items sorted (stable). 'dynarr' is left untouched
+int dynarr_argsort(
+    const DynArrAllocator *allocator,
+    const DynArr *dynarr,
+    DynArrComparator comparator,
+    DynArr **out_indexes
+);
+// Extracts a 'key_size' bytes key once per item, sorts the keys and then
+// moves every item to its final position just once. 'key_comparator'
+// receives pointers to keys
+int dynarr_sort_by_key(
+    DynArr *dynarr,
+    size_t key_size,
+    DynArrKeyExtractor extractor,
+    DynArrComparator key_comparator
+);
 int dynarr_find(const DynArr *dynarr, const void *item, DynArrComparator comparator);
 
 #define DYNARR_FIND(_dynarr, _comparator, _type, ...) \
@@ -108,6 +246,264 @@ int dynarr_join(
 
 int dynarr_remove_index(DynArr *dynarr, size_t idx);
 int dynarr_remove_if(DynArr *dynarr, DynArrPredicate predicate, void *ctx);
+// Unordered removes: the last item takes the place of the removed one
+int dynarr_swap_remove(DynArr *dynarr, size_t idx);
+// 'idxs' is a DynArr of size_t, duplicates are allowed
+int dynarr_swap_remove_many(DynArr *dynarr, const DynArr *idxs);
+// 'out_item' can be NULL
+int dynarr_pop(DynArr *dynarr, void *out_item);
 void dynarr_remove_all(DynArr *dynarr);
 
+// Binary file: a header (item size, length and checksum) followed by the
+// raw items, in native byte order
+int dynarr_save(const DynArr *dynarr, const char *path);
+int dynarr_load(const DynArrAllocator *allocator, const char *path, DynArr **out_dynarr);
+// The returned DynArr reads its items straight from the mapped file. The
+// first write detaches it into a private heap copy, as with dynarr_clone.
+// The checksum is not verified
+int dynarr_map_readonly(const DynArrAllocator *allocator, const char *path, DynArr **out_dynarr);
+
+// Opens (or creates) a file in the dynarr_save format and keeps the
+// returned DynArr backed by it. Writes are tracked as dirty ranges and
+// dynarr_persist_flush writes only those, then publishes the new length
+// and checksum in the header once the items are durable. Appends are
+// crash safe, in place edits of already published items are not.
+// Unflushed changes are lost on dynarr_destroy
+int dynarr_persist_open(
+    const DynArrAllocator *allocator,
+    const char *path,
+    size_t item_size,
+    DynArr **out_dynarr
+);
+int dynarr_persist_flush(DynArr *dynarr);
+
+// PUBLIC INTERFACE DYNARR BATCH
+// Records inserts and removes to apply later in a single sweep over the
+// array, with at most one reallocation. Indexes mean the same as if
+// every edit was applied right away, in the order they were recorded
+// Applying k edits to n items costs O(n + k log k), against O(n * k)
+// for the same edits made one at a time
+DynArrBatch *dynarr_batch_create(const DynArrAllocator *allocator, size_t item_size);
+void dynarr_batch_destroy(DynArrBatch *batch);
+
+size_t dynarr_batch_len(const DynArrBatch *batch);
+int dynarr_batch_insert_at(DynArrBatch *batch, size_t idx, const void *item);
+int dynarr_batch_remove_index(DynArrBatch *batch, size_t idx);
+void dynarr_batch_clear(DynArrBatch *batch);
+// If any edit is out of bounds nothing is applied. The batch is kept,
+// call dynarr_batch_clear to reuse it
+int dynarr_batch_apply(DynArr *dynarr, DynArrBatch *batch);
+
+#define DYNARR_BATCH_INSERT_AT(_batch, _idx, _type, ...) \
+    (dynarr_batch_insert_at((_batch), (_idx), &(_type){__VA_ARGS__}))
+
+// PUBLIC INTERFACE DYNARR VIEW
+// Range [from, to) of 'dynarr'
+int dynarr_view(const DynArr *dynarr, size_t from, size_t to, DynArrView *out_view);
+int dynarr_view_slice(const DynArrView *view, size_t from, size_t to, DynArrView *out_view);
+size_t dynarr_view_len(const DynArrView *view);
+const void *dynarr_view_get_raw(const DynArrView *view, size_t idx);
+
+#define DYNARR_VIEW_GET_AS(_view, _as, _idx) \
+    (*(const _as *)(dynarr_view_get_raw((_view), (_idx))))
+
+// PUBLIC INTERFACE DYNARR COLS
+// Struct of arrays: one column per field, all sharing the same length.
+// Rows are inserted and removed as a whole through 'fields', an array
+// holding one pointer per column
+DynArrCols *dynarr_cols_create(
+    const DynArrAllocator *allocator,
+    size_t col_count,
+    const size_t *col_item_sizes
+);
+void dynarr_cols_destroy(DynArrCols *cols);
+
+size_t dynarr_cols_len(const DynArrCols *cols);
+size_t dynarr_cols_count(const DynArrCols *cols);
+const DynArr *dynarr_cols_column(const DynArrCols *cols, size_t col);
+void *dynarr_cols_get_raw(const DynArrCols *cols, size_t col, size_t idx);
+
+#define DYNARR_COLS_GET_AS(_cols, _col, _as, _idx) \
+    (*(_as *)(dynarr_cols_get_raw((_cols), (_col), (_idx))))
+
+int dynarr_cols_set_at(DynArrCols *cols, size_t col, size_t idx, const void *item);
+int dynarr_cols_insert(DynArrCols *cols, const void *const *fields);
+int dynarr_cols_insert_at(DynArrCols *cols, size_t idx, const void *const *fields);
+int dynarr_cols_remove_index(DynArrCols *cols, size_t idx);
+int dynarr_cols_remove_if(
+    DynArrCols *cols,
+    size_t col,
+    DynArrPredicate predicate,
+    void *ctx
+);
+void dynarr_cols_remove_all(DynArrCols *cols);
+int dynarr_cols_sort(DynArrCols *cols, size_t key_col, DynArrComparator comparator);
+
+// PUBLIC INTERFACE DYNARR BITS
+// Bit packed array, 64 flags per word
+DynArrBits *dynarr_bits_create(const DynArrAllocator *allocator);
+void dynarr_bits_destroy(DynArrBits *bits);
+
+size_t dynarr_bits_len(const DynArrBits *bits);
+// Returns the bit value (0 or 1), or -1 if 'idx' is out of bounds
+int dynarr_bits_get(const DynArrBits *bits, size_t idx);
+int dynarr_bits_set(DynArrBits *bits, size_t idx, int value);
+int dynarr_bits_push(DynArrBits *bits, int value);
+int dynarr_bits_insert_at(DynArrBits *bits, size_t idx, int value);
+int dynarr_bits_remove_index(DynArrBits *bits, size_t idx);
+void dynarr_bits_remove_all(DynArrBits *bits);
+
+size_t dynarr_bits_popcount(const DynArrBits *bits);
+// Both return 1 and store the index in 'out_idx' if a bit was found
+// at or after 'from', 0 otherwise
+int dynarr_bits_find_first_set(const DynArrBits *bits, size_t from, size_t *out_idx);
+int dynarr_bits_find_first_clear(const DynArrBits *bits, size_t from, size_t *out_idx);
+
+// 'to' op= 'from', word by word. Both must have the same length and may
+// be the same DynArrBits
+int dynarr_bits_and(DynArrBits *to, const DynArrBits *from);
+int dynarr_bits_or(DynArrBits *to, const DynArrBits *from);
+int dynarr_bits_xor(DynArrBits *to, const DynArrBits *from);
+void dynarr_bits_not(DynArrBits *bits);
+
+// PUBLIC INTERFACE DYNARR POOL
+// Threads used by the dynarr_parallel_* functions. The calling thread
+// works too. A NULL pool, or arrays under DYNARR_PARALLEL_THRESHOLD
+// items, run serially. Work is split in chunks spanning whole cache
+// lines, and idle threads steal chunks from busy ones.
+// A pool runs one job at a time: it must not be used from two threads
+// at once, nor from inside one of its own callbacks (that deadlocks)
+DynArrPool *dynarr_pool_create(const DynArrAllocator *allocator, size_t thread_count);
+void dynarr_pool_destroy(DynArrPool *pool);
+
+int dynarr_parallel_for_each(
+    DynArrPool *pool,
+    DynArr *dynarr,
+    DynArrForEach for_each,
+    void *ctx
+);
+// 'to' gets as many items as 'from', growing if needed
+int dynarr_parallel_map(
+    DynArrPool *pool,
+    const DynArr *from,
+    DynArr *to,
+    DynArrMapper mapper,
+    void *ctx
+);
+// 'combiner' must be associative, it is not required to be commutative
+int dynarr_parallel_reduce(
+    DynArrPool *pool,
+    const DynArr *dynarr,
+    const void *identity,
+    DynArrCombiner combiner,
+    void *ctx,
+    void *out_result
+);
+// Inclusive scan, in place
+int dynarr_parallel_prefix_scan(
+    DynArrPool *pool,
+    DynArr *dynarr,
+    const void *identity,
+    DynArrCombiner combiner,
+    void *ctx
+);
+
+// PUBLIC INTERFACE DYNARR PACKED
+// Frozen compressed copy of a sorted DynArr of uint32_t or uint64_t.
+// Values are delta encoded and bit packed in blocks of 128, each block
+// with the width its largest delta needs
+int dynarr_packed_create(
+    const DynArrAllocator *allocator,
+    const DynArr *sorted,
+    DynArrPacked **out_packed
+);
+void dynarr_packed_destroy(DynArrPacked *packed);
+
+size_t dynarr_packed_len(const DynArrPacked *packed);
+// Bytes used by the compressed representation
+size_t dynarr_packed_size(const DynArrPacked *packed);
+// Index of the first value not less than 'value', the length if none.
+// Only the one block that can hold it is decoded
+size_t dynarr_packed_lower_bound(const DynArrPacked *packed, uint64_t value);
+int dynarr_packed_find(const DynArrPacked *packed, uint64_t value, size_t *out_idx);
+// Appends every value to 'out', which must have the original item size
+int dynarr_packed_decode(const DynArrPacked *packed, DynArr *out);
+
+// PUBLIC INTERFACE DYNARR MEMORY
+// Accounting of the items buffers of every live DynArr. Growth that
+// would take the reserved bytes past the limit calls the pressure
+// callback, then fails with ALLOC_ERR_DYNARR_CODE if still over.
+// A zero limit, the default, means no limit
+void dynarr_set_memory_limit(size_t limit);
+void dynarr_set_memory_pressure(DynArrMemoryPressure on_pressure, void *ctx);
+void dynarr_memory_stats(DynArrMemoryStats *out_stats);
+// Shrinks every array to its length and returns the bytes released.
+// Must not run while other threads use the arrays
+size_t dynarr_trim_all(void);
+
+// PUBLIC INTERFACE DYNARR VAR
+// Variable length items (strings, blobs...) stored back to back in one
+// byte arena, plus a table of their offsets and sizes
+DynArrVar *dynarr_var_create(const DynArrAllocator *allocator);
+void dynarr_var_destroy(DynArrVar *var);
+
+size_t dynarr_var_len(const DynArrVar *var);
+// Bytes of payload in the arena
+size_t dynarr_var_bytes(const DynArrVar *var);
+// Room for 'count' more items with 'bytes' more payload in one allocation each
+int dynarr_var_reserve(DynArrVar *var, size_t count, size_t bytes);
+int dynarr_var_push(DynArrVar *var, const void *payload, size_t size);
+// Pointer to the payload of item 'idx', or NULL if out of bounds. Valid
+// until the next push, remove or sort. Payloads are packed, not aligned
+const void *dynarr_var_get(const DynArrVar *var, size_t idx, size_t *out_size);
+// Returns how many items were removed. The arena is compacted after
+int dynarr_var_remove_if(DynArrVar *var, DynArrVarPredicate predicate, void *ctx);
+void dynarr_var_remove_all(DynArrVar *var);
+// Stable. Payloads are laid out again in the sorted order
+int dynarr_var_sort(DynArrVar *var, DynArrVarComparator comparator);
+
+// PUBLIC INTERFACE DYNARR PMA
+// Sorted array with gaps spread through it (packed memory array). Inserts
+// and removes move items only within the smallest window whose density
+// stays in bounds, amortized O(log^2 n) moves
+DynArrPma *dynarr_pma_create(
+    const DynArrAllocator *allocator,
+    size_t item_size,
+    DynArrComparator comparator
+);
+void dynarr_pma_destroy(DynArrPma *pma);
+
+size_t dynarr_pma_len(const DynArrPma *pma);
+// Slots, counting the gaps
+size_t dynarr_pma_capacity(const DynArrPma *pma);
+// Equal items are kept, after the ones already there
+int dynarr_pma_insert(DynArrPma *pma, const void *item);
+// Removes one item equal to 'item'. Returns 1 if found, 0 otherwise
+int dynarr_pma_remove(DynArrPma *pma, const void *item);
+const void *dynarr_pma_find(const DynArrPma *pma, const void *item);
+// Cursor from which dynarr_pma_next yields the items not less than 'item'
+size_t dynarr_pma_lower_bound(const DynArrPma *pma, const void *item);
+// In order iteration: start 'cursor' at 0 (or a lower bound) and call
+// until NULL. Cursors and pointers are invalidated by insert and remove
+const void *dynarr_pma_next(const DynArrPma *pma, size_t *cursor);
+
+// PUBLIC INTERFACE DYNARR CURSOR
+// Range [from, to) of 'dynarr', taken as written: clones and mapped
+// arrays get their own copy first. Loop on dynarr_cursor_next until it
+// returns 0 and walk each span without bounds checks
+int dynarr_cursor(DynArr *dynarr, size_t from, size_t to, DynArrCursor *out_cursor);
+// Next span of at most 'max_count' items (0 for no limit). Returns 1,
+// or 0 once the range is exhausted
+int dynarr_cursor_next(DynArrCursor *cursor, size_t max_count, DynArrSpan *out_span);
+// Same as dynarr_cursor for reading only, so clones and mapped arrays
+// stay shared
+int dynarr_const_cursor(const DynArr *dynarr, size_t from, size_t to, DynArrConstCursor *out_cursor);
+int dynarr_const_cursor_next(DynArrConstCursor *cursor, size_t max_count, DynArrConstSpan *out_span);
+// Calls 'block_fn' once per DYNARR_BLOCK_BYTES worth of items, with the
+// next block prefetched. 'block_fn' must not insert or remove items
+int dynarr_for_each_batch(const DynArr *dynarr, DynArrBlockFn block_fn, void *ctx);
+
+#define DYNARR_SPAN_AT(_span, _as, _idx) \
+    (*(_as *)((_span)->items + (_idx) * (_span)->stride))
+
 #endif
\ No newline at end of file
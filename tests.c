@@ -3,10 +3,18 @@
 #include <stdio.h>
 #include <limits.h>
 #include <assert.h>
+#include <string.h>
 
 #define PRT_TEST_BEIGN() printf("%s...", __func__)
 #define PRT_TEST_END() printf(" success!\n")
 
+int compare_int(const void *a, const void *b){
+    int a_value = *(const int *)a;
+    int b_value = *(const int *)b;
+
+    return (a_value > b_value) - (a_value < b_value);
+}
+
 void test_dynarr_test_0(){
     PRT_TEST_BEIGN();
 
@@ -319,7 +327,7 @@ void test_dynarr_join_0(){
 
     assert(DYNARR_INSERT(a, char, CHAR_MAX) == OK_DYNARR_CODE);
     assert(DYNARR_INSERT(b, int, INT_MAX) == OK_DYNARR_CODE);
-    assert(dynarr_join(a, b, NULL, NULL) == SIZE_MISMATCH_ERR_DYNARR_CODE);
+    assert(dynarr_join(NULL, a, b, NULL) == SIZE_MISMATCH_ERR_DYNARR_CODE);
 
     dynarr_destroy(a);
     dynarr_destroy(b);
@@ -346,7 +354,7 @@ void test_dynarr_join_1(){
     assert(DYNARR_INSERT(b, int, 9) == OK_DYNARR_CODE);
     assert(DYNARR_INSERT(b, int, 10) == OK_DYNARR_CODE);
 
-    assert(dynarr_join(a, b, NULL, &c) == OK_DYNARR_CODE);
+    assert(dynarr_join(NULL, a, b, &c) == OK_DYNARR_CODE);
 
     assert(DYNARR_GET_AS(c, int, 0) == 1);
     assert(DYNARR_GET_AS(c, int, 1) == 2);
@@ -426,32 +434,1379 @@ void test_dynarr_remove_index_2(){
     PRT_TEST_END();
 }
 
-int main(void) {
-    test_dynarr_test_0();
-    test_dynarr_create_by_0();
+void test_dynarr_nth_element_0(){
+    PRT_TEST_BEIGN();
 
-    test_dynarr_set_at_0();
-    test_dynarr_set_at_1();
+    DynArr *values = DYNARR_CREATE_TYPE(NULL, int);
+    size_t itms_len = 1000;
 
-    test_dynarr_insert_0();
-    test_dynarr_insert_1();
-    test_dynarr_insert_2();
+    for (size_t i = 0; i < itms_len; i++){
+        assert(DYNARR_INSERT(values, int, (int)((i * 7919) % itms_len)) == OK_DYNARR_CODE);
+    }
 
-    test_dynarr_insert_at_0();
-    test_dynarr_insert_at_1();
-    test_dynarr_insert_at_2();
-    test_dynarr_insert_at_3();
+    assert(dynarr_nth_element(values, itms_len, compare_int) == IDX_OUT_OF_BOUNDS_ERR_DYNARR_CODE);
+    assert(dynarr_nth_element(values, 500, compare_int) == OK_DYNARR_CODE);
+    assert(DYNARR_GET_AS(values, int, 500) == 500);
 
-    test_dynarr_append_0();
-    test_dynarr_append_1();
-    test_dynarr_append_2();
+    for (size_t i = 0; i < itms_len; i++){
+        if(i < 500){
+            assert(DYNARR_GET_AS(values, int, i) < 500);
+        }else{
+            assert(DYNARR_GET_AS(values, int, i) >= 500);
+        }
+    }
 
-    test_dynarr_join_0();
-    test_dynarr_join_1();
+    dynarr_destroy(values);
 
-    test_dynarr_remove_index_0();
-    test_dynarr_remove_index_1();
-    test_dynarr_remove_index_2();
+    PRT_TEST_END();
+}
+
+void test_dynarr_partial_sort_0(){
+    PRT_TEST_BEIGN();
+
+    DynArr *values = DYNARR_CREATE_TYPE(NULL, int);
+    size_t itms_len = 1000;
+
+    for (size_t i = 0; i < itms_len; i++){
+        assert(DYNARR_INSERT(values, int, (int)(itms_len - i)) == OK_DYNARR_CODE);
+    }
+
+    assert(dynarr_partial_sort(values, 10, compare_int) == OK_DYNARR_CODE);
+    assert(dynarr_len(values) == itms_len);
+
+    for (size_t i = 0; i < 10; i++){
+        assert(DYNARR_GET_AS(values, int, i) == (int)(i + 1));
+    }
+
+    dynarr_destroy(values);
+
+    PRT_TEST_END();
+}
+
+void test_dynarr_top_k_0(){
+    PRT_TEST_BEIGN();
+
+    DynArr *top = DYNARR_CREATE_TYPE(NULL, int);
+
+    for (int i = 0; i < 1000; i++){
+        int value = (i * 7919) % 1000;
+        assert(dynarr_top_k_push(top, 5, &value, compare_int) == OK_DYNARR_CODE);
+    }
+
+    assert(dynarr_len(top) == 5);
+
+    // a rejected push must not unshare a clone
+    DynArr *copy = dynarr_clone(top);
+    DynArrView before;
+    DynArrView after;
+    int rejected = 500;
+
+    assert(copy);
+    assert(dynarr_view(top, 0, 5, &before) == OK_DYNARR_CODE);
+    assert(dynarr_top_k_push(copy, 5, &rejected, compare_int) == OK_DYNARR_CODE);
+    assert(dynarr_view(copy, 0, 5, &after) == OK_DYNARR_CODE);
+    assert(after.items == before.items);
+
+    dynarr_destroy(copy);
+
+    dynarr_top_k_sort(top, compare_int);
+
+    for (size_t i = 0; i < 5; i++){
+        assert(DYNARR_GET_AS(top, int, i) == (int)i);
+    }
+
+    dynarr_destroy(top);
+
+    PRT_TEST_END();
+}
+
+typedef struct record{
+    int key;
+    char payload[60];
+}Record;
+
+void extract_record_key(const void *item, void *out_key){
+    *(int *)out_key = ((const Record *)item)->key;
+}
+
+void test_dynarr_argsort_0(){
+    PRT_TEST_BEIGN();
+
+    DynArr *values = DYNARR_CREATE_TYPE(NULL, int);
+    DynArr *indexes = NULL;
+
+    assert(DYNARR_INSERT(values, int, 30) == OK_DYNARR_CODE);
+    assert(DYNARR_INSERT(values, int, 10) == OK_DYNARR_CODE);
+    assert(DYNARR_INSERT(values, int, 20) == OK_DYNARR_CODE);
+    assert(DYNARR_INSERT(values, int, 10) == OK_DYNARR_CODE);
+
+    assert(dynarr_argsort(NULL, values, compare_int, &indexes) == OK_DYNARR_CODE);
+    assert(dynarr_len(indexes) == 4);
+    assert(DYNARR_GET_AS(indexes, size_t, 0) == 1);
+    assert(DYNARR_GET_AS(indexes, size_t, 1) == 3);
+    assert(DYNARR_GET_AS(indexes, size_t, 2) == 2);
+    assert(DYNARR_GET_AS(indexes, size_t, 3) == 0);
+    assert(DYNARR_GET_AS(values, int, 0) == 30);
+
+    dynarr_destroy(indexes);
+    dynarr_remove_all(values);
+
+    assert(dynarr_argsort(NULL, values, compare_int, &indexes) == OK_DYNARR_CODE);
+    assert(dynarr_len(indexes) == 0);
+
+    dynarr_destroy(values);
+    dynarr_destroy(indexes);
+
+    PRT_TEST_END();
+}
+
+void test_dynarr_sort_by_key_0(){
+    PRT_TEST_BEIGN();
+
+    DynArr *records = DYNARR_CREATE_TYPE(NULL, Record);
+    size_t itms_len = 100;
+
+    for (size_t i = 0; i < itms_len; i++){
+        Record record = {.key = (int)((i * 37) % itms_len)};
+
+        snprintf(record.payload, sizeof(record.payload), "%d", record.key);
+        assert(dynarr_insert(records, &record) == OK_DYNARR_CODE);
+    }
+
+    assert(dynarr_sort_by_key(records, sizeof(int), extract_record_key, compare_int) == OK_DYNARR_CODE);
+
+    for (size_t i = 0; i < itms_len; i++){
+        Record record = DYNARR_GET_AS(records, Record, i);
+
+        assert(record.key == (int)i);
+        assert(atoi(record.payload) == (int)i);
+    }
+
+    dynarr_destroy(records);
+
+    PRT_TEST_END();
+}
+
+int is_odd_int(const void *item, void *ctx){
+    (void)ctx;
+    return *(const int *)item % 2 != 0;
+}
+
+void test_dynarr_cols_0(){
+    PRT_TEST_BEIGN();
+
+    size_t col_item_sizes[] = {sizeof(int), sizeof(double)};
+    DynArrCols *cols = dynarr_cols_create(NULL, 2, col_item_sizes);
+
+    for (int i = 0; i < 20; i++){
+        int key = 19 - i;
+        double value = key * 0.5;
+        const void *fields[] = {&key, &value};
+
+        assert(dynarr_cols_insert(cols, fields) == OK_DYNARR_CODE);
+    }
+
+    int key = 100;
+    double value = 50.0;
+    const void *fields[] = {&key, &value};
+
+    assert(dynarr_cols_insert_at(cols, 21, fields) == IDX_OUT_OF_BOUNDS_ERR_DYNARR_CODE);
+    assert(dynarr_cols_insert_at(cols, 0, fields) == OK_DYNARR_CODE);
+    assert(dynarr_cols_len(cols) == 21);
+    assert(dynarr_len(dynarr_cols_column(cols, 1)) == 21);
+
+    assert(dynarr_cols_remove_index(cols, 0) == OK_DYNARR_CODE);
+    assert(dynarr_cols_remove_if(cols, 0, is_odd_int, NULL) == 10);
+    assert(dynarr_cols_len(cols) == 10);
+
+    assert(dynarr_cols_sort(cols, 0, compare_int) == OK_DYNARR_CODE);
+
+    for (size_t i = 0; i < dynarr_cols_len(cols); i++){
+        assert(DYNARR_COLS_GET_AS(cols, 0, int, i) == (int)(i * 2));
+        assert(DYNARR_COLS_GET_AS(cols, 1, double, i) == i * 2 * 0.5);
+    }
+
+    dynarr_cols_destroy(cols);
+
+    PRT_TEST_END();
+}
+
+void test_dynarr_bits_0(){
+    PRT_TEST_BEIGN();
+
+    DynArrBits *bits = dynarr_bits_create(NULL);
+    size_t bits_len = 200;
+
+    for (size_t i = 0; i < bits_len; i++){
+        assert(dynarr_bits_push(bits, i % 3 == 0) == OK_DYNARR_CODE);
+    }
+
+    assert(dynarr_bits_len(bits) == bits_len);
+    assert(dynarr_bits_get(bits, bits_len) == -1);
+    assert(dynarr_bits_popcount(bits) == 67);
+
+    assert(dynarr_bits_insert_at(bits, 10, 1) == OK_DYNARR_CODE);
+    assert(dynarr_bits_len(bits) == bits_len + 1);
+
+    for (size_t i = 0; i <= bits_len; i++){
+        int expected = i == 10 ? 1 : (i < 10 ? i : i - 1) % 3 == 0;
+        assert(dynarr_bits_get(bits, i) == expected);
+    }
+
+    assert(dynarr_bits_remove_index(bits, 10) == OK_DYNARR_CODE);
+
+    for (size_t i = 0; i < bits_len; i++){
+        assert(dynarr_bits_get(bits, i) == (i % 3 == 0));
+    }
+
+    size_t idx = 0;
+
+    assert(dynarr_bits_find_first_set(bits, 64, &idx) == 1);
+    assert(idx == 66);
+    assert(dynarr_bits_find_first_clear(bits, 0, &idx) == 1);
+    assert(idx == 1);
+
+    dynarr_bits_destroy(bits);
+
+    PRT_TEST_END();
+}
+
+void test_dynarr_bits_1(){
+    PRT_TEST_BEIGN();
+
+    DynArrBits *a = dynarr_bits_create(NULL);
+    DynArrBits *b = dynarr_bits_create(NULL);
+
+    for (size_t i = 0; i < 100; i++){
+        assert(dynarr_bits_push(a, i % 2 == 0) == OK_DYNARR_CODE);
+        assert(dynarr_bits_push(b, i % 4 == 0) == OK_DYNARR_CODE);
+    }
+
+    assert(dynarr_bits_and(a, b) == OK_DYNARR_CODE);
+    assert(dynarr_bits_popcount(a) == 25);
+
+    dynarr_bits_not(a);
+    assert(dynarr_bits_popcount(a) == 75);
+
+    assert(dynarr_bits_xor(a, b) == OK_DYNARR_CODE);
+    assert(dynarr_bits_popcount(a) == 100);
+
+    size_t idx = 0;
+
+    assert(dynarr_bits_find_first_clear(a, 0, &idx) == 0);
+    assert(dynarr_bits_push(b, 1) == OK_DYNARR_CODE);
+    assert(dynarr_bits_or(a, b) == SIZE_MISMATCH_ERR_DYNARR_CODE);
+
+    assert(dynarr_bits_and(a, a) == OK_DYNARR_CODE);
+    assert(dynarr_bits_popcount(a) == 100);
+    assert(dynarr_bits_xor(a, a) == OK_DYNARR_CODE);
+    assert(dynarr_bits_popcount(a) == 0);
+
+    dynarr_bits_destroy(a);
+    dynarr_bits_destroy(b);
+
+    PRT_TEST_END();
+}
+
+void test_dynarr_clone_0(){
+    PRT_TEST_BEIGN();
+
+    DynArr *values = DYNARR_CREATE_TYPE(NULL, int);
+
+    for (int i = 0; i < 10; i++){
+        assert(DYNARR_INSERT(values, int, i) == OK_DYNARR_CODE);
+    }
+
+    DynArr *clone = dynarr_clone(values);
+
+    assert(clone);
+    assert(dynarr_get_raw(clone, 0) == dynarr_get_raw(values, 0));
+
+    assert(DYNARR_SET_AT(clone, 0, int, 100) == OK_DYNARR_CODE);
+    assert(dynarr_get_raw(clone, 0) != dynarr_get_raw(values, 0));
+    assert(DYNARR_GET_AS(values, int, 0) == 0);
+    assert(DYNARR_GET_AS(clone, int, 0) == 100);
+
+    for (size_t i = 1; i < 10; i++){
+        assert(DYNARR_GET_AS(clone, int, i) == (int)i);
+    }
+
+    dynarr_destroy(values);
+    dynarr_destroy(clone);
+
+    PRT_TEST_END();
+}
+
+void test_dynarr_clone_1(){
+    PRT_TEST_BEIGN();
+
+    DynArr *values = DYNARR_CREATE_TYPE(NULL, int);
+
+    for (int i = 0; i < 10; i++){
+        assert(DYNARR_INSERT(values, int, 9 - i) == OK_DYNARR_CODE);
+    }
+
+    DynArr *clone = dynarr_clone(values);
+
+    dynarr_destroy(values);
+
+    assert(dynarr_sort(clone, compare_int) == OK_DYNARR_CODE);
+
+    for (size_t i = 0; i < 10; i++){
+        assert(DYNARR_GET_AS(clone, int, i) == (int)i);
+    }
+
+    dynarr_destroy(clone);
+
+    PRT_TEST_END();
+}
+
+void test_dynarr_view_0(){
+    PRT_TEST_BEIGN();
+
+    DynArr *values = DYNARR_CREATE_TYPE(NULL, int);
+    DynArrView view;
+    DynArrView slice;
+
+    for (int i = 0; i < 10; i++){
+        assert(DYNARR_INSERT(values, int, i) == OK_DYNARR_CODE);
+    }
+
+    assert(dynarr_view(values, 5, 11, &view) == IDX_OUT_OF_BOUNDS_ERR_DYNARR_CODE);
+    assert(dynarr_view(values, 2, 8, &view) == OK_DYNARR_CODE);
+    assert(dynarr_view_len(&view) == 6);
+    assert(DYNARR_VIEW_GET_AS(&view, int, 0) == 2);
+    assert(dynarr_view_get_raw(&view, 6) == NULL);
+
+    assert(dynarr_view_slice(&view, 1, 3, &slice) == OK_DYNARR_CODE);
+    assert(dynarr_view_len(&slice) == 2);
+    assert(DYNARR_VIEW_GET_AS(&slice, int, 1) == 4);
+
+    dynarr_destroy(values);
+
+    PRT_TEST_END();
+}
+
+void test_dynarr_save_0(){
+    PRT_TEST_BEIGN();
+
+    const char *path = "dynarr_test_save_0.bin";
+    DynArr *values = DYNARR_CREATE_TYPE(NULL, int);
+    DynArr *loaded = NULL;
+    DynArr *mapped = NULL;
+
+    for (int i = 0; i < 100; i++){
+        assert(DYNARR_INSERT(values, int, i * 3) == OK_DYNARR_CODE);
+    }
+
+    assert(dynarr_save(values, path) == OK_DYNARR_CODE);
+    assert(dynarr_load(NULL, path, &loaded) == OK_DYNARR_CODE);
+    assert(dynarr_map_readonly(NULL, path, &mapped) == OK_DYNARR_CODE);
+
+    assert(dynarr_len(loaded) == 100);
+    assert(dynarr_len(mapped) == 100);
+
+    for (size_t i = 0; i < 100; i++){
+        assert(DYNARR_GET_AS(loaded, int, i) == (int)i * 3);
+        assert(DYNARR_GET_AS(mapped, int, i) == (int)i * 3);
+    }
+
+    assert(dynarr_find(mapped, &(int){297}, compare_int) == 99);
+    assert(DYNARR_INSERT(mapped, int, 300) == OK_DYNARR_CODE);
+    assert(DYNARR_GET_AS(mapped, int, 100) == 300);
+    assert(DYNARR_GET_AS(mapped, int, 0) == 0);
+
+    dynarr_destroy(values);
+    dynarr_destroy(loaded);
+    dynarr_destroy(mapped);
+    remove(path);
+
+    PRT_TEST_END();
+}
+
+void test_dynarr_load_0(){
+    PRT_TEST_BEIGN();
+
+    const char *path = "dynarr_test_load_0.bin";
+    FILE *file = fopen(path, "wb");
+    DynArr *loaded = NULL;
+
+    assert(file);
+    assert(fputs("not a dynarr file, not a dynarr file", file) >= 0);
+    assert(fclose(file) == 0);
+
+    assert(dynarr_load(NULL, path, &loaded) == FORMAT_ERR_DYNARR_CODE);
+    assert(dynarr_map_readonly(NULL, path, &loaded) == FORMAT_ERR_DYNARR_CODE);
+    assert(loaded == NULL);
+
+    // a valid file whose header claims far more items than it holds
+    typedef struct{long a; long b;}Pair;
+    DynArr *pairs = DYNARR_CREATE_TYPE(NULL, Pair);
+    uint64_t len = SIZE_MAX / sizeof(Pair);
+
+    assert(DYNARR_INSERT(pairs, Pair, 1, 2) == OK_DYNARR_CODE);
+    assert(dynarr_save(pairs, path) == OK_DYNARR_CODE);
+
+    file = fopen(path, "r+b");
+
+    // len sits after the magic, version and item size
+    assert(file);
+    assert(fseek(file, 16, SEEK_SET) == 0);
+    assert(fwrite(&len, sizeof(len), 1, file) == 1);
+    assert(fclose(file) == 0);
+
+    assert(dynarr_load(NULL, path, &loaded) == FORMAT_ERR_DYNARR_CODE);
+    assert(dynarr_map_readonly(NULL, path, &loaded) == FORMAT_ERR_DYNARR_CODE);
+    assert(loaded == NULL);
+
+    dynarr_destroy(pairs);
+    remove(path);
+
+    PRT_TEST_END();
+}
+
+void test_dynarr_persist_0(){
+    PRT_TEST_BEIGN();
+
+    const char *path = "dynarr_test_persist_0.bin";
+    DynArr *values = NULL;
+    DynArr *loaded = NULL;
+
+    remove(path);
+
+    assert(dynarr_persist_open(NULL, path, sizeof(int), &values) == OK_DYNARR_CODE);
+    assert(dynarr_len(values) == 0);
+
+    for (int i = 0; i < 50; i++){
+        assert(DYNARR_INSERT(values, int, i) == OK_DYNARR_CODE);
+    }
+
+    assert(dynarr_persist_flush(values) == OK_DYNARR_CODE);
+
+    for (int i = 50; i < 75; i++){
+        assert(DYNARR_INSERT(values, int, i) == OK_DYNARR_CODE);
+    }
+
+    assert(dynarr_persist_flush(values) == OK_DYNARR_CODE);
+    assert(DYNARR_INSERT(values, int, 1000) == OK_DYNARR_CODE);
+
+    dynarr_destroy(values);
+
+    assert(dynarr_persist_open(NULL, path, sizeof(char), &values) == SIZE_MISMATCH_ERR_DYNARR_CODE);
+    assert(dynarr_persist_open(NULL, path, sizeof(int), &values) == OK_DYNARR_CODE);
+    assert(dynarr_len(values) == 75);
+
+    for (size_t i = 0; i < 75; i++){
+        assert(DYNARR_GET_AS(values, int, i) == (int)i);
+    }
+
+    assert(DYNARR_SET_AT(values, 10, int, -10) == OK_DYNARR_CODE);
+    assert(dynarr_remove_index(values, 74) == OK_DYNARR_CODE);
+    assert(dynarr_persist_flush(values) == OK_DYNARR_CODE);
+
+    dynarr_destroy(values);
+
+    assert(dynarr_load(NULL, path, &loaded) == OK_DYNARR_CODE);
+    assert(dynarr_len(loaded) == 74);
+    assert(DYNARR_GET_AS(loaded, int, 10) == -10);
+    assert(DYNARR_GET_AS(loaded, int, 73) == 73);
+
+    dynarr_destroy(loaded);
+    remove(path);
+
+    PRT_TEST_END();
+}
+
+void add_long(void *acc, const void *item, void *ctx){
+    (void)ctx;
+    *(long *)acc += *(const long *)item;
+}
+
+void double_long(const void *item, void *out_item, void *ctx){
+    (void)ctx;
+    *(long *)out_item = *(const long *)item * 2;
+}
+
+void set_long_to_idx(void *item, size_t idx, void *ctx){
+    (void)ctx;
+    *(long *)item = (long)idx;
+}
+
+void test_dynarr_parallel_0(){
+    PRT_TEST_BEIGN();
+
+    DynArrPool *pool = dynarr_pool_create(NULL, 3);
+    DynArr *values = DYNARR_CREATE_TYPE(NULL, long);
+    DynArr *doubled = DYNARR_CREATE_TYPE(NULL, long);
+    size_t itms_len = 100000;
+    long identity = 0;
+    long sum = 0;
+
+    for (size_t i = 0; i < itms_len; i++){
+        assert(DYNARR_INSERT(values, long, 0) == OK_DYNARR_CODE);
+    }
+
+    assert(dynarr_parallel_for_each(pool, values, set_long_to_idx, NULL) == OK_DYNARR_CODE);
+    assert(dynarr_parallel_reduce(pool, values, &identity, add_long, NULL, &sum) == OK_DYNARR_CODE);
+    assert(sum == (long)(itms_len * (itms_len - 1) / 2));
+
+    assert(dynarr_parallel_map(pool, values, doubled, double_long, NULL) == OK_DYNARR_CODE);
+    assert(dynarr_len(doubled) == itms_len);
+    assert(DYNARR_GET_AS(doubled, long, itms_len - 1) == (long)(itms_len - 1) * 2);
+
+    assert(dynarr_parallel_prefix_scan(pool, values, &identity, add_long, NULL) == OK_DYNARR_CODE);
+
+    for (size_t i = 0; i < itms_len; i++){
+        assert(DYNARR_GET_AS(values, long, i) == (long)(i * (i + 1) / 2));
+    }
+
+    dynarr_destroy(values);
+    dynarr_destroy(doubled);
+    dynarr_pool_destroy(pool);
+
+    PRT_TEST_END();
+}
+
+void test_dynarr_parallel_1(){
+    PRT_TEST_BEIGN();
+
+    DynArr *values = DYNARR_CREATE_TYPE(NULL, long);
+    long identity = 0;
+    long sum = 0;
+
+    for (long i = 1; i <= 10; i++){
+        assert(DYNARR_INSERT(values, long, i) == OK_DYNARR_CODE);
+    }
+
+    assert(dynarr_parallel_reduce(NULL, values, &identity, add_long, NULL, &sum) == OK_DYNARR_CODE);
+    assert(sum == 55);
+
+    assert(dynarr_parallel_prefix_scan(NULL, values, &identity, add_long, NULL) == OK_DYNARR_CODE);
+    assert(DYNARR_GET_AS(values, long, 9) == 55);
+
+    dynarr_destroy(values);
+
+    PRT_TEST_END();
+}
+
+// like malloc, except that zero bytes are refused and counted in 'ctx'
+void *strict_alloc(size_t size, void *ctx){
+    if(size == 0){
+        *(size_t *)ctx += 1;
+        return NULL;
+    }
+
+    return malloc(size);
+}
+
+void *strict_realloc(void *ptr, size_t old_size, size_t new_size, void *ctx){
+    (void)old_size;
+
+    if(new_size == 0){
+        *(size_t *)ctx += 1;
+        return NULL;
+    }
+
+    return realloc(ptr, new_size);
+}
+
+void strict_dealloc(void *ptr, size_t size, void *ctx){
+    (void)size;
+    (void)ctx;
+    free(ptr);
+}
+
+void test_dynarr_parallel_2(){
+    PRT_TEST_BEIGN();
+
+    size_t refused = 0;
+    DynArrAllocator allocator = {
+        .ctx = &refused,
+        .alloc = strict_alloc,
+        .realloc = strict_realloc,
+        .dealloc = strict_dealloc
+    };
+    DynArr *values = DYNARR_CREATE_TYPE(&allocator, long);
+    long identity = 7;
+    long sum = 0;
+
+    assert(dynarr_parallel_reduce(NULL, values, &identity, add_long, NULL, &sum) == OK_DYNARR_CODE);
+    assert(sum == 7);
+    assert(dynarr_parallel_prefix_scan(NULL, values, &identity, add_long, NULL) == OK_DYNARR_CODE);
+    assert(dynarr_len(values) == 0);
+    assert(refused == 0);
+
+    dynarr_destroy(values);
+
+    PRT_TEST_END();
+}
+
+void test_dynarr_batch_0(){
+    PRT_TEST_BEIGN();
+
+    DynArr *batched = DYNARR_CREATE_TYPE(NULL, int);
+    DynArr *sequential = DYNARR_CREATE_TYPE(NULL, int);
+    DynArrBatch *batch = dynarr_batch_create(NULL, sizeof(int));
+    unsigned int seed = 7;
+
+    for (int i = 0; i < 200; i++){
+        assert(DYNARR_INSERT(batched, int, i) == OK_DYNARR_CODE);
+        assert(DYNARR_INSERT(sequential, int, i) == OK_DYNARR_CODE);
+    }
+
+    for (int i = 0; i < 300; i++){
+        size_t len = dynarr_len(sequential);
+
+        seed = seed * 1103515245 + 12345;
+
+        if(len > 0 && (seed >> 16) % 3 == 0){
+            size_t idx = (seed >> 8) % len;
+
+            assert(dynarr_batch_remove_index(batch, idx) == OK_DYNARR_CODE);
+            assert(dynarr_remove_index(sequential, idx) == OK_DYNARR_CODE);
+        }else{
+            size_t idx = (seed >> 8) % (len + 1);
+
+            assert(DYNARR_BATCH_INSERT_AT(batch, idx, int, 1000 + i) == OK_DYNARR_CODE);
+            assert(DYNARR_INSERT_AT(sequential, idx, int, 1000 + i) == OK_DYNARR_CODE);
+        }
+    }
+
+    assert(dynarr_batch_len(batch) == 300);
+    assert(dynarr_batch_apply(batched, batch) == OK_DYNARR_CODE);
+    assert(dynarr_len(batched) == dynarr_len(sequential));
+
+    for (size_t i = 0; i < dynarr_len(sequential); i++){
+        assert(DYNARR_GET_AS(batched, int, i) == DYNARR_GET_AS(sequential, int, i));
+    }
+
+    dynarr_batch_destroy(batch);
+    dynarr_destroy(batched);
+    dynarr_destroy(sequential);
+
+    PRT_TEST_END();
+}
+
+void test_dynarr_batch_1(){
+    PRT_TEST_BEIGN();
+
+    DynArr *values = DYNARR_CREATE_TYPE(NULL, int);
+    DynArrBatch *batch = dynarr_batch_create(NULL, sizeof(int));
+
+    assert(DYNARR_INSERT(values, int, 1) == OK_DYNARR_CODE);
+    assert(DYNARR_INSERT(values, int, 2) == OK_DYNARR_CODE);
+
+    assert(dynarr_batch_remove_index(batch, 0) == OK_DYNARR_CODE);
+    assert(dynarr_batch_remove_index(batch, 1) == OK_DYNARR_CODE);
+    assert(dynarr_batch_apply(values, batch) == IDX_OUT_OF_BOUNDS_ERR_DYNARR_CODE);
+    assert(dynarr_len(values) == 2);
+    assert(DYNARR_GET_AS(values, int, 0) == 1);
+
+    dynarr_batch_destroy(batch);
+    dynarr_destroy(values);
+
+    PRT_TEST_END();
+}
+
+void test_dynarr_swap_remove_0(){
+    PRT_TEST_BEIGN();
+
+    DynArr *values = DYNARR_CREATE_TYPE(NULL, int);
+    int value = 0;
+
+    assert(dynarr_swap_remove(values, 0) == IDX_OUT_OF_BOUNDS_ERR_DYNARR_CODE);
+    assert(dynarr_pop(values, &value) == DYNARR_EMPTY_ERR_DYNARR_CODE);
+
+    for (int i = 0; i < 5; i++){
+        assert(DYNARR_INSERT(values, int, i) == OK_DYNARR_CODE);
+    }
+
+    assert(dynarr_swap_remove(values, 1) == OK_DYNARR_CODE);
+    assert(dynarr_len(values) == 4);
+    assert(DYNARR_GET_AS(values, int, 1) == 4);
+
+    assert(dynarr_pop(values, &value) == OK_DYNARR_CODE);
+    assert(value == 3);
+    assert(dynarr_len(values) == 3);
+
+    dynarr_destroy(values);
+
+    PRT_TEST_END();
+}
+
+void test_dynarr_swap_remove_many_0(){
+    PRT_TEST_BEIGN();
+
+    DynArr *values = DYNARR_CREATE_TYPE(NULL, int);
+    DynArr *idxs = DYNARR_CREATE_TYPE(NULL, size_t);
+
+    for (int i = 0; i < 10; i++){
+        assert(DYNARR_INSERT(values, int, i) == OK_DYNARR_CODE);
+    }
+
+    assert(DYNARR_INSERT(idxs, size_t, 2) == OK_DYNARR_CODE);
+    assert(DYNARR_INSERT(idxs, size_t, 9) == OK_DYNARR_CODE);
+    assert(DYNARR_INSERT(idxs, size_t, 8) == OK_DYNARR_CODE);
+    assert(DYNARR_INSERT(idxs, size_t, 2) == OK_DYNARR_CODE);
+    assert(DYNARR_INSERT(idxs, size_t, 0) == OK_DYNARR_CODE);
+
+    assert(dynarr_swap_remove_many(values, idxs) == OK_DYNARR_CODE);
+    assert(dynarr_len(values) == 6);
+
+    for (size_t i = 0; i < dynarr_len(values); i++){
+        int value = DYNARR_GET_AS(values, int, i);
+
+        assert(value != 0 && value != 2 && value != 8 && value != 9);
+    }
+
+    assert(DYNARR_INSERT(idxs, size_t, 6) == OK_DYNARR_CODE);
+    assert(dynarr_swap_remove_many(values, idxs) == IDX_OUT_OF_BOUNDS_ERR_DYNARR_CODE);
+
+    dynarr_destroy(values);
+    dynarr_destroy(idxs);
+
+    PRT_TEST_END();
+}
+
+void test_dynarr_set_alignment_0(){
+    PRT_TEST_BEIGN();
+
+    DynArr *values = DYNARR_CREATE_TYPE(NULL, char);
+
+    assert(dynarr_set_alignment(values, 24) == INCORRECT_SIZE_ERR_DYNARR_CODE);
+    assert(DYNARR_INSERT(values, char, 1) == OK_DYNARR_CODE);
+    assert(dynarr_set_alignment(values, 64) == OK_DYNARR_CODE);
+    assert(dynarr_alignment(values) == 64);
+    assert((uintptr_t)dynarr_get_raw(values, 0) % 64 == 0);
+    assert(DYNARR_GET_AS(values, char, 0) == 1);
+
+    for (int i = 0; i < 1000; i++){
+        assert(DYNARR_INSERT(values, char, (char)i) == OK_DYNARR_CODE);
+        assert((uintptr_t)dynarr_get_raw(values, 0) % 64 == 0);
+    }
+
+    assert(dynarr_set_alignment(values, DYNARR_PAGE_ALIGNMENT) == OK_DYNARR_CODE);
+    assert((uintptr_t)dynarr_get_raw(values, 0) % 4096 == 0);
+
+    DynArr *joined = NULL;
+
+    assert(dynarr_join(NULL, values, values, &joined) == OK_DYNARR_CODE);
+    assert((uintptr_t)dynarr_get_raw(joined, 0) % 4096 == 0);
+    assert(dynarr_len(joined) == 2002);
+
+    dynarr_destroy(values);
+    dynarr_destroy(joined);
+
+    PRT_TEST_END();
+}
+
+void test_dynarr_packed_0(){
+    PRT_TEST_BEIGN();
+
+    DynArr *ids = DYNARR_CREATE_TYPE(NULL, uint32_t);
+    DynArr *decoded = DYNARR_CREATE_TYPE(NULL, uint32_t);
+    DynArrPacked *packed = NULL;
+    size_t ids_len = 1000;
+    size_t idx = 0;
+
+    for (uint32_t i = 0; i < ids_len; i++){
+        assert(DYNARR_INSERT(ids, uint32_t, 100 + i * 3 + (i % 7 == 0)) == OK_DYNARR_CODE);
+    }
+
+    assert(dynarr_packed_create(NULL, ids, &packed) == OK_DYNARR_CODE);
+    assert(dynarr_packed_len(packed) == ids_len);
+    assert(dynarr_packed_size(packed) < ids_len * sizeof(uint32_t) / 2);
+
+    assert(dynarr_packed_lower_bound(packed, 0) == 0);
+    assert(dynarr_packed_lower_bound(packed, 102) == 1);
+    assert(dynarr_packed_lower_bound(packed, UINT32_MAX) == ids_len);
+    assert(dynarr_packed_find(packed, DYNARR_GET_AS(ids, uint32_t, 500), &idx) == 1);
+    assert(idx == 500);
+    assert(dynarr_packed_find(packed, 102, &idx) == 0);
+
+    assert(dynarr_packed_decode(packed, decoded) == OK_DYNARR_CODE);
+    assert(dynarr_len(decoded) == ids_len);
+
+    for (size_t i = 0; i < ids_len; i++){
+        assert(DYNARR_GET_AS(decoded, uint32_t, i) == DYNARR_GET_AS(ids, uint32_t, i));
+    }
+
+    dynarr_packed_destroy(packed);
+    dynarr_destroy(ids);
+    dynarr_destroy(decoded);
+
+    PRT_TEST_END();
+}
+
+void test_dynarr_packed_1(){
+    PRT_TEST_BEIGN();
+
+    DynArr *ids = DYNARR_CREATE_TYPE(NULL, uint64_t);
+    DynArrPacked *packed = NULL;
+
+    assert(DYNARR_INSERT(ids, uint64_t, 5) == OK_DYNARR_CODE);
+    assert(DYNARR_INSERT(ids, uint64_t, UINT64_MAX) == OK_DYNARR_CODE);
+    assert(dynarr_packed_create(NULL, ids, &packed) == OK_DYNARR_CODE);
+    assert(dynarr_packed_lower_bound(packed, 6) == 1);
+
+    dynarr_packed_destroy(packed);
+
+    assert(DYNARR_INSERT(ids, uint64_t, 1) == OK_DYNARR_CODE);
+    assert(dynarr_packed_create(NULL, ids, &packed) == NOT_SORTED_ERR_DYNARR_CODE);
+
+    dynarr_destroy(ids);
+
+    PRT_TEST_END();
+}
+
+void test_dynarr_packed_2(){
+    PRT_TEST_BEIGN();
+
+    DynArr *ids = DYNARR_CREATE_TYPE(NULL, uint32_t);
+    DynArrPacked *packed = NULL;
+    size_t idx = 0;
+
+    // equal values spanning several blocks
+    for (size_t i = 0; i < 300; i++){
+        assert(DYNARR_INSERT(ids, uint32_t, 5) == OK_DYNARR_CODE);
+    }
+
+    assert(dynarr_packed_create(NULL, ids, &packed) == OK_DYNARR_CODE);
+    assert(dynarr_packed_lower_bound(packed, 5) == 0);
+    assert(dynarr_packed_lower_bound(packed, 6) == 300);
+    assert(dynarr_packed_find(packed, 5, &idx) == 1 && idx == 0);
+
+    dynarr_packed_destroy(packed);
+    dynarr_remove_all(ids);
+
+    // equal values starting right before a block boundary
+    for (uint32_t i = 0; i < 127; i++){
+        assert(DYNARR_INSERT(ids, uint32_t, i) == OK_DYNARR_CODE);
+    }
+
+    for (size_t i = 0; i < 10; i++){
+        assert(DYNARR_INSERT(ids, uint32_t, 200) == OK_DYNARR_CODE);
+    }
+
+    assert(dynarr_packed_create(NULL, ids, &packed) == OK_DYNARR_CODE);
+    assert(dynarr_packed_lower_bound(packed, 200) == 127);
+    assert(dynarr_packed_lower_bound(packed, 150) == 127);
+    assert(dynarr_packed_find(packed, 200, &idx) == 1 && idx == 127);
+    assert(dynarr_packed_find(packed, 150, &idx) == 0);
+
+    dynarr_packed_destroy(packed);
+    dynarr_destroy(ids);
+
+    PRT_TEST_END();
+}
+
+void trim_on_pressure(size_t excess, void *ctx){
+    (void)excess;
+    *(int *)ctx += 1;
+    dynarr_trim_all();
+}
+
+void test_dynarr_memory_0(){
+    PRT_TEST_BEIGN();
+
+    DynArrMemoryStats stats = {0};
+    DynArr *spare = DYNARR_CREATE_TYPE_BY(NULL, long, 1000);
+    DynArr *values = DYNARR_CREATE_TYPE(NULL, long);
+    int pressured = 0;
+
+    assert(DYNARR_INSERT(spare, long, 1) == OK_DYNARR_CODE);
+
+    dynarr_memory_stats(&stats);
+
+    assert(stats.arrays >= 2);
+    assert(stats.reserved >= sizeof(long) * 1000);
+
+    // values can only reach 128 items once spare gives back its capacity
+    dynarr_set_memory_pressure(trim_on_pressure, &pressured);
+    dynarr_set_memory_limit(stats.reserved + sizeof(long) * 64);
+
+    for (long i = 0; i < 128; i++){
+        assert(DYNARR_INSERT(values, long, i) == OK_DYNARR_CODE);
+    }
+
+    assert(pressured == 1);
+    assert(dynarr_capacity(spare) == 1);
+
+    dynarr_memory_stats(&stats);
+    dynarr_set_memory_limit(stats.reserved);
+
+    for (long i = 0; i < 1024 * 1024 && DYNARR_INSERT(values, long, i) == OK_DYNARR_CODE; i++){
+    }
+
+    dynarr_memory_stats(&stats);
+
+    assert(pressured == 2);
+    assert(stats.reserved <= stats.limit);
+    assert(dynarr_len(values) < 1024 * 1024);
+
+    dynarr_set_memory_limit(0);
+    dynarr_set_memory_pressure(NULL, NULL);
+
+    dynarr_destroy(spare);
+    dynarr_destroy(values);
+
+    PRT_TEST_END();
+}
+
+void test_dynarr_memory_1(){
+    PRT_TEST_BEIGN();
+
+    DynArrMemoryStats before = {0};
+    DynArrMemoryStats after = {0};
+    DynArr *values = DYNARR_CREATE_TYPE_EXACT(NULL, char, 1000);
+    int pressured = 0;
+
+    assert(DYNARR_INSERT(values, char, 1) == OK_DYNARR_CODE);
+
+    dynarr_memory_stats(&before);
+
+    // the callback trims the very array that is growing
+    dynarr_set_memory_pressure(trim_on_pressure, &pressured);
+    dynarr_set_memory_limit(before.reserved + 500);
+
+    assert(dynarr_reserve(values, 1600) == ALLOC_ERR_DYNARR_CODE);
+    assert(pressured == 1);
+    assert(dynarr_capacity(values) == 1);
+
+    dynarr_memory_stats(&after);
+
+    assert(after.reserved == before.reserved - 999);
+
+    dynarr_set_memory_limit(0);
+    dynarr_set_memory_pressure(NULL, NULL);
+    dynarr_destroy(values);
+
+    dynarr_memory_stats(&after);
+
+    assert(after.reserved == before.reserved - 1000);
+
+    PRT_TEST_END();
+}
+
+size_t init_and_forget(){
+    char raw_values[dynarr_size()];
+    DynArr *values = DYNARR_INIT_TYPE(raw_values, int, NULL);
+    DynArrMemoryStats stats = {0};
+
+    dynarr_memory_stats(&stats);
+
+    // an empty array owns nothing, so skipping deinit here is fine
+    return stats.arrays + dynarr_len(values);
+}
+
+void test_dynarr_memory_2(){
+    PRT_TEST_BEIGN();
+
+    DynArrMemoryStats stats = {0};
+
+    dynarr_memory_stats(&stats);
+
+    // the storage of the init'd array is gone, the registry never had it
+    assert(init_and_forget() == stats.arrays);
+
+    dynarr_trim_all();
+    dynarr_memory_stats(&stats);
+
+    assert(init_and_forget() == stats.arrays);
+
+    PRT_TEST_END();
+}
+
+void test_dynarr_reserve_0(){
+    PRT_TEST_BEIGN();
+
+    DynArr *values = DYNARR_CREATE_TYPE_EXACT(NULL, int, 100);
+    DynArr *more = DYNARR_CREATE_TYPE(NULL, int);
+
+    assert(dynarr_capacity(values) == 100);
+
+    for (int i = 0; i < 100; i++){
+        assert(DYNARR_INSERT(values, int, i) == OK_DYNARR_CODE);
+    }
+
+    assert(dynarr_capacity(values) == 100);
+
+    assert(dynarr_reserve(values, 50) == OK_DYNARR_CODE);
+    assert(dynarr_capacity(values) == 100);
+    assert(dynarr_reserve(values, 150) == OK_DYNARR_CODE);
+    assert(dynarr_capacity(values) == 150);
+
+    for (int i = 0; i < 50; i++){
+        assert(DYNARR_INSERT(more, int, i) == OK_DYNARR_CODE);
+    }
+
+    assert(dynarr_append(values, more) == OK_DYNARR_CODE);
+    assert(dynarr_capacity(values) == 150);
+    assert(dynarr_len(values) == 150);
+
+    assert(dynarr_make_room(more, 3) == OK_DYNARR_CODE);
+    assert(dynarr_capacity(more) == 64);
+
+    assert(dynarr_make_room(more, 20) == OK_DYNARR_CODE);
+    assert(dynarr_capacity(more) == 72);
+
+    assert(dynarr_shrink_to_fit(more) == OK_DYNARR_CODE);
+    assert(dynarr_capacity(more) == 50);
+    assert(DYNARR_GET_AS(more, int, 49) == 49);
+
+    dynarr_remove_all(more);
+
+    assert(dynarr_shrink_to_fit(more) == OK_DYNARR_CODE);
+    assert(dynarr_capacity(more) == 0);
+    assert(DYNARR_INSERT(more, int, 7) == OK_DYNARR_CODE);
+
+    dynarr_destroy(values);
+    dynarr_destroy(more);
+
+    PRT_TEST_END();
+}
+
+int compare_payload(const void *a, size_t a_size, const void *b, size_t b_size){
+    size_t min_size = a_size < b_size ? a_size : b_size;
+    int comparison = memcmp(a, b, min_size);
+
+    if(comparison != 0){
+        return comparison;
+    }
+
+    return (a_size > b_size) - (a_size < b_size);
+}
+
+int is_short_payload(const void *payload, size_t size, void *ctx){
+    (void)payload;
+
+    return size < *(size_t *)ctx;
+}
+
+void test_dynarr_var_0(){
+    PRT_TEST_BEIGN();
+
+    const char *words[] = {"pear", "fig", "banana", "", "apple", "kiwi", "cherry"};
+    size_t words_len = sizeof(words) / sizeof(words[0]);
+    DynArrVar *var = dynarr_var_create(NULL);
+    size_t size = 0;
+    size_t min_size = 4;
+
+    assert(dynarr_var_reserve(var, words_len, 64) == OK_DYNARR_CODE);
+
+    for (size_t i = 0; i < words_len; i++){
+        assert(dynarr_var_push(var, words[i], strlen(words[i])) == OK_DYNARR_CODE);
+    }
+
+    assert(dynarr_var_len(var) == words_len);
+    assert(dynarr_var_bytes(var) == 28);
+    assert(memcmp(dynarr_var_get(var, 2, &size), "banana", 6) == 0);
+    assert(size == 6);
+    assert(dynarr_var_get(var, 3, &size) && size == 0);
+    assert(dynarr_var_get(var, words_len, &size) == NULL);
+
+    assert(dynarr_var_sort(var, compare_payload) == OK_DYNARR_CODE);
+    assert(dynarr_var_get(var, 0, &size) && size == 0);
+    assert(memcmp(dynarr_var_get(var, 1, &size), "apple", 5) == 0 && size == 5);
+    assert(memcmp(dynarr_var_get(var, 6, &size), "pear", 4) == 0 && size == 4);
+
+    assert(dynarr_var_remove_if(var, is_short_payload, &min_size) == 2);
+    assert(dynarr_var_len(var) == 5);
+    assert(dynarr_var_bytes(var) == 25);
+    assert(memcmp(dynarr_var_get(var, 0, &size), "apple", 5) == 0);
+    assert(memcmp(dynarr_var_get(var, 3, &size), "kiwi", 4) == 0);
+
+    for (size_t i = 0; i < 1000; i++){
+        assert(dynarr_var_push(var, &i, sizeof(i)) == OK_DYNARR_CODE);
+    }
+
+    size_t last = 0;
+
+    // payloads are packed, not aligned
+    memcpy(&last, dynarr_var_get(var, 5 + 999, &size), sizeof(last));
+
+    assert(size == sizeof(last) && last == 999);
+
+    dynarr_var_destroy(var);
+
+    PRT_TEST_END();
+}
+
+int compare_payload_not_null(const void *a, size_t a_size, const void *b, size_t b_size){
+    assert(a && b);
+
+    return compare_payload(a, a_size, b, b_size);
+}
+
+int is_short_payload_not_null(const void *payload, size_t size, void *ctx){
+    assert(payload);
+
+    return is_short_payload(payload, size, ctx);
+}
+
+int is_non_empty_payload(const void *payload, size_t size, void *ctx){
+    (void)ctx;
+    assert(payload);
+
+    return size > 0;
+}
+
+void test_dynarr_var_1(){
+    PRT_TEST_BEIGN();
+
+    size_t refused = 0;
+    DynArrAllocator allocator = {
+        .ctx = &refused,
+        .alloc = strict_alloc,
+        .realloc = strict_realloc,
+        .dealloc = strict_dealloc
+    };
+    DynArrVar *var = dynarr_var_create(&allocator);
+    size_t size = 1;
+    size_t min_size = 1;
+
+    assert(dynarr_var_sort(var, compare_payload_not_null) == OK_DYNARR_CODE);
+
+    // only empty payloads, so the arena is never allocated
+    assert(dynarr_var_push(var, "", 0) == OK_DYNARR_CODE);
+    assert(dynarr_var_push(var, NULL, 0) == OK_DYNARR_CODE);
+
+    assert(dynarr_var_bytes(var) == 0);
+    assert(dynarr_var_get(var, 0, &size) != NULL && size == 0);
+    assert(dynarr_var_get(var, 1, &size) != NULL && size == 0);
+
+    assert(dynarr_var_sort(var, compare_payload_not_null) == OK_DYNARR_CODE);
+    assert(dynarr_var_remove_if(var, is_short_payload_not_null, &min_size) == 2);
+    assert(dynarr_var_len(var) == 0);
+
+    // compacting away the only non empty payload leaves no arena either
+    assert(dynarr_var_push(var, "fig", 3) == OK_DYNARR_CODE);
+    assert(dynarr_var_push(var, "", 0) == OK_DYNARR_CODE);
+    assert(dynarr_var_remove_if(var, is_non_empty_payload, NULL) == 1);
+
+    assert(dynarr_var_len(var) == 1);
+    assert(dynarr_var_get(var, 0, &size) != NULL && size == 0);
+    assert(dynarr_var_sort(var, compare_payload_not_null) == OK_DYNARR_CODE);
+    assert(refused == 0);
+
+    dynarr_var_destroy(var);
+
+    PRT_TEST_END();
+}
+
+void test_dynarr_pma_0(){
+    PRT_TEST_BEIGN();
+
+    DynArrPma *pma = dynarr_pma_create(NULL, sizeof(int), compare_int);
+    DynArr *expected = DYNARR_CREATE_TYPE(NULL, int);
+    unsigned int seed = 7;
+    size_t cursor = 0;
+    const int *item = NULL;
+
+    for (int i = 0; i < 5000; i++){
+        seed = seed * 1103515245 + 12345;
+
+        int value = (int)(seed >> 16) % 2000;
+
+        assert(dynarr_pma_insert(pma, &value) == OK_DYNARR_CODE);
+        assert(DYNARR_INSERT(expected, int, value) == OK_DYNARR_CODE);
+    }
+
+    assert(dynarr_sort(expected, compare_int) == OK_DYNARR_CODE);
+
+    // every other value out, so gaps open all over the array
+    for (int value = 0; value < 2000; value += 2){
+        while (dynarr_pma_remove(pma, &value)){
+            dynarr_remove_index(expected, (size_t)dynarr_find(expected, &value, compare_int));
+        }
+    }
+
+    assert(dynarr_pma_len(pma) == dynarr_len(expected));
+    assert(dynarr_pma_capacity(pma) >= dynarr_pma_len(pma));
+
+    for (size_t i = 0; i < dynarr_len(expected); i++){
+        item = dynarr_pma_next(pma, &cursor);
+
+        assert(item && *item == DYNARR_GET_AS(expected, int, i));
+    }
+
+    assert(dynarr_pma_next(pma, &cursor) == NULL);
+
+    int middle = DYNARR_GET_AS(expected, int, dynarr_len(expected) / 2);
+
+    assert(dynarr_pma_find(pma, &(int){4}) == NULL);
+    assert(*(const int *)dynarr_pma_find(pma, &middle) == middle);
+
+    cursor = dynarr_pma_lower_bound(pma, &(int){middle - 1});
+    item = dynarr_pma_next(pma, &cursor);
+
+    assert(item && *item == middle);
+
+    dynarr_pma_destroy(pma);
+    dynarr_destroy(expected);
+
+    PRT_TEST_END();
+}
+
+void sum_block(const DynArrConstSpan *span, size_t first_idx, void *ctx){
+    long *totals = ctx;
+
+    assert(span->count > 0 && span->stride == sizeof(long));
+
+    for (size_t i = 0; i < span->count; i++){
+        assert(DYNARR_SPAN_AT(span, long, i) == (long)(first_idx + i));
+
+        totals[0] += DYNARR_SPAN_AT(span, long, i);
+    }
+
+    totals[1]++;
+}
+
+void test_dynarr_cursor_0(){
+    PRT_TEST_BEIGN();
+
+    DynArr *values = DYNARR_CREATE_TYPE(NULL, long);
+    DynArrCursor cursor;
+    DynArrSpan span;
+    long totals[2] = {0};
+    size_t spans = 0;
+    size_t seen = 0;
+
+    for (long i = 0; i < 10000; i++){
+        assert(DYNARR_INSERT(values, long, i) == OK_DYNARR_CODE);
+    }
+
+    assert(dynarr_cursor(values, 10, 10001, &cursor) == IDX_OUT_OF_BOUNDS_ERR_DYNARR_CODE);
+    assert(dynarr_cursor(values, 10, 110, &cursor) == OK_DYNARR_CODE);
+
+    while (dynarr_cursor_next(&cursor, 30, &span)){
+        for (size_t i = 0; i < span.count; i++){
+            DYNARR_SPAN_AT(&span, long, i) *= 2;
+        }
+
+        seen += span.count;
+        spans++;
+    }
+
+    assert(seen == 100 && spans == 4);
+    assert(DYNARR_GET_AS(values, long, 9) == 9);
+    assert(DYNARR_GET_AS(values, long, 10) == 20);
+    assert(DYNARR_GET_AS(values, long, 109) == 218);
+    assert(DYNARR_GET_AS(values, long, 110) == 110);
+
+    for (size_t i = 10; i < 110; i++){
+        assert(DYNARR_SET_AT(values, i, long, (long)i) == OK_DYNARR_CODE);
+    }
+
+    assert(dynarr_for_each_batch(values, sum_block, totals) == OK_DYNARR_CODE);
+    assert(totals[0] == 10000L * 9999 / 2);
+    assert(totals[1] > 1);
+
+    // reading a clone leaves it sharing the items of 'values'
+    DynArr *copy = dynarr_clone(values);
+    DynArrConstCursor const_cursor;
+    DynArrConstSpan const_span;
+    DynArrView before;
+    DynArrView after;
+
+    assert(copy);
+    assert(dynarr_view(values, 0, 10000, &before) == OK_DYNARR_CODE);
+
+    totals[0] = 0;
+
+    assert(dynarr_for_each_batch(copy, sum_block, totals) == OK_DYNARR_CODE);
+    assert(totals[0] == 10000L * 9999 / 2);
+
+    assert(dynarr_const_cursor(copy, 10, 10001, &const_cursor) == IDX_OUT_OF_BOUNDS_ERR_DYNARR_CODE);
+    assert(dynarr_const_cursor(copy, 9990, 10000, &const_cursor) == OK_DYNARR_CODE);
+    assert(dynarr_const_cursor_next(&const_cursor, 0, &const_span) == 1);
+    assert(const_span.count == 10 && DYNARR_SPAN_AT(&const_span, long, 0) == 9990);
+    assert(dynarr_const_cursor_next(&const_cursor, 0, &const_span) == 0);
+
+    assert(dynarr_view(copy, 0, 10000, &after) == OK_DYNARR_CODE);
+    assert(after.items == before.items);
+
+    dynarr_destroy(copy);
+    dynarr_destroy(values);
+
+    PRT_TEST_END();
+}
+
+int main(void) {
+    test_dynarr_test_0();
+    test_dynarr_create_by_0();
+
+    test_dynarr_set_at_0();
+    test_dynarr_set_at_1();
+
+    test_dynarr_insert_0();
+    test_dynarr_insert_1();
+    test_dynarr_insert_2();
+
+    test_dynarr_insert_at_0();
+    test_dynarr_insert_at_1();
+    test_dynarr_insert_at_2();
+    test_dynarr_insert_at_3();
+
+    test_dynarr_append_0();
+    test_dynarr_append_1();
+    test_dynarr_append_2();
+
+    test_dynarr_join_0();
+    test_dynarr_join_1();
+
+    test_dynarr_remove_index_0();
+    test_dynarr_remove_index_1();
+    test_dynarr_remove_index_2();
+
+    test_dynarr_nth_element_0();
+    test_dynarr_partial_sort_0();
+    test_dynarr_top_k_0();
+
+    test_dynarr_argsort_0();
+    test_dynarr_sort_by_key_0();
+
+    test_dynarr_cols_0();
+
+    test_dynarr_bits_0();
+    test_dynarr_bits_1();
+
+    test_dynarr_clone_0();
+    test_dynarr_clone_1();
+    test_dynarr_view_0();
+
+    test_dynarr_save_0();
+    test_dynarr_load_0();
+    test_dynarr_persist_0();
+
+    test_dynarr_parallel_0();
+    test_dynarr_parallel_1();
+    test_dynarr_parallel_2();
+
+    test_dynarr_batch_0();
+    test_dynarr_batch_1();
+
+    test_dynarr_swap_remove_0();
+    test_dynarr_swap_remove_many_0();
+
+    test_dynarr_set_alignment_0();
+
+    test_dynarr_packed_0();
+    test_dynarr_packed_1();
+    test_dynarr_packed_2();
+
+    test_dynarr_memory_0();
+    test_dynarr_memory_1();
+    test_dynarr_memory_2();
+
+    test_dynarr_reserve_0();
+
+    test_dynarr_var_0();
+    test_dynarr_var_1();
+
+    test_dynarr_pma_0();
+
+    test_dynarr_cursor_0();
 
     return 0;
 }
\ No newline at end of file